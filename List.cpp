@@ -1,647 +1,478 @@
+#include <math.h>
+#include <chrono>
 
-#include "List.h"
-#include "lib/System_utils.h"
-
-#ifndef LIST_NO_CANARY
-    static const ptrdiff_t LIST_DATA_BEGIN_OFFSET      =   sizeof(canary_t);
-    static const ptrdiff_t LIST_DATA_PTR_BEGIN_OFFSET  =   sizeof(canary_t);
-    static const ptrdiff_t LIST_DATA_SIZE_OFFSET       = 2*sizeof(canary_t);
-    static const ptrdiff_t LIST_DATA_PTR_SIZE_OFFSET   = 2*sizeof(canary_t);
-
+#ifdef _WIN32
+    #include <windows.h>
 #else
-    static const ptrdiff_t LIST_DATA_BEGIN_OFFSET      = 0;
-    static const ptrdiff_t LIST_DATA_PTR_BEGIN_OFFSET  = 0;
-    static const ptrdiff_t LIST_DATA_SIZE_OFFSET       = 0;
-    static const ptrdiff_t LIST_DATA_PTR_SIZE_OFFSET   = 0;
+    #include <sys/mman.h>
+    #include <unistd.h>
 #endif
 
-#define DESTRUCT_PTR ((void*)0xBAD)
-
-#ifndef LIST_NO_PROTECT
-    #define listCheckRet(__lst, ...)  \
-        if(listError(__lst)){             \
-            Error_log("%s", "List error");\
-            listDump(__lst);              \
-            return __VA_ARGS__;            \
-        }
+#if defined(__linux__)
+    #define LIST_USE_MREMAP 1
 #else
-    #define listCheckRet(__lst, ...) ;
+    #define LIST_USE_MREMAP 0
 #endif
 
-#ifndef LIST_NO_PROTECT
-    #define listCheckRetPtr(__lst, __errptr, ...)  \
-        if(listError(__lst)){                \
-            Error_log("%s", "List error");   \
-            listDump(__lst);                 \
-            if(__errptr)                      \
-                *__errptr = listError(__lst);\
-            return __VA_ARGS__;               \
-        }
-#else
-    #define listCheckRetPtr(__lst, __errptr, ...)  ;
-#endif
-
-inline static void* listDataMemBegin(const List* lst){
-    assert_log(lst != nullptr);
-    return ((uint8_t*)lst->data)-LIST_DATA_BEGIN_OFFSET;
-}
-inline static size_t listDataMemSize(const List* lst){
-    assert_log(lst != nullptr);
-    return (lst->capacity*sizeof(LIST_ELEM_T)) + LIST_DATA_SIZE_OFFSET ;
-}
+#include "List.h"
 
-inline static size_t listDataPtrMemSize(const List* lst){
-    assert_log(lst != nullptr);
-    return (lst->capacity*sizeof(size_t)) + LIST_DATA_SIZE_OFFSET;
-}
+bool listAllocOrResize(void** ptr, size_t new_size, size_t offset){
+    char* new_mem = nullptr;
+    errno = 0;
 
-bool listCtor_(List* lst){
-    #ifndef LIST_NO_PROTECT
-    if (!isPtrWritable(lst, sizeof(lst))){
+    if (*ptr != nullptr){
+        new_mem = (char*)realloc((char*)(*ptr) - offset, new_size);
+    }
+    else{
+        new_mem = (char*)calloc(new_size, 1);
+    }
+    if (new_mem == nullptr){
+        perror_log("error while reallocating memory");
         return false;
     }
-    #endif
-
-    lst->data = nullptr;
-    lst->prev = nullptr;
-    lst->next = nullptr;
-
-    lst->fmem_stack = 0;
-    lst->fmem_end   = 1;
-
-    lst->capacity = 0;
-    lst->size = 0;
-
-    #ifndef LIST_NO_CANARY
-        lst->leftcan  = CANARY_L;
-        lst->rightcan = CANARY_R;
-    #endif
+    *ptr = new_mem + offset;
     return true;
 }
 
-varError_t listError(const List* lst){
-
-    if (lst == nullptr)
-        return VAR_NULL;
-
-    if (!isPtrReadable(lst, sizeof(lst)))
-        return VAR_BAD;
-
-    if (lst->capacity == SIZE_MAX || lst->data == DESTRUCT_PTR)
-        return VAR_DEAD;
-
+#if LIST_USE_MREMAP
 
-    unsigned int err = 0;
-
-    if (lst->capacity != 0){
-        if (lst->data == nullptr)
-            err |= VAR_DATA_NULL;
-        if (!isPtrWritable(listDataMemBegin(lst), listDataMemSize(lst)))
-            err |= VAR_DATA_BAD;
-
-        if (lst->prev == nullptr)
-            err |= VAR_DATA_NULL;
-        if (!isPtrWritable(lst->prev - LIST_DATA_BEGIN_OFFSET, listDataPtrMemSize(lst)))
-            err |= VAR_DATA_BAD;
-
-        if (lst->next == nullptr)
-            err |= VAR_DATA_NULL;
-        if (!isPtrWritable(lst->next - LIST_DATA_BEGIN_OFFSET, listDataPtrMemSize(lst)))
-            err |= VAR_DATA_BAD;
-    }
+static size_t listPageRound(size_t size){
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
 
-    if (lst->fmem_stack >= lst->fmem_end ||
-        lst->size       >= lst->fmem_end ||
-        lst->fmem_end   > lst->capacity + 1)
-    {
-        err |= VAR_BADSTATE;
-    }
+static char* listMapPages(size_t size){
+    void* mem = mmap(nullptr, listPageRound(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (mem == MAP_FAILED) ? nullptr : (char*)mem;
+}
 
-    #ifndef LIST_NO_CANARY
-        if (lst->leftcan != CANARY_L){
-            err |= VAR_CANARY_L_BAD;
+#endif // LIST_USE_MREMAP
+
+bool listStorageResize(void** ptr, size_t old_size, size_t new_size, size_t offset, bool zero){
+#if LIST_USE_MREMAP
+    char* old_mem = (*ptr == nullptr) ? nullptr : (char*)(*ptr) - offset;
+    bool old_map = (old_mem != nullptr && old_size >= LIST_MAP_MIN_SIZE);
+    bool new_map = (new_size >= LIST_MAP_MIN_SIZE);
+
+    if (old_map || new_map){
+        char* new_mem = nullptr;
+        errno = 0;
+        if (old_map && new_map){
+            //kernel moves page mappings, data is not copied
+            void* mem = mremap(old_mem, listPageRound(old_size), listPageRound(new_size), MREMAP_MAYMOVE);
+            new_mem = (mem == MAP_FAILED) ? nullptr : (char*)mem;
         }
-        if (lst->rightcan != CANARY_R){
-            err |= VAR_CANARY_R_BAD;
+        else{
+            new_mem = new_map ? listMapPages(new_size) : (char*)(zero ? calloc(new_size, 1) : malloc(new_size));
+            if (new_mem != nullptr && old_mem != nullptr){
+                memcpy(new_mem, old_mem, (old_size < new_size) ? old_size : new_size);
+                listStorageFree(*ptr, old_size, offset);
+            }
         }
-    #endif
-
-    if ((err & VAR_DATA_BAD) || lst->data == nullptr){
-        return (varError_t)err;
-    }
-    if (lst->next[0]    >= lst->fmem_end ||
-        lst->prev[0]    >= lst->fmem_end){
-        err |= VAR_BADSTATE;
+        if (new_mem == nullptr){
+            perror_log("error while reallocating memory");
+            return false;
+        }
+        *ptr = new_mem + offset;
+        return true;
     }
+#endif // LIST_USE_MREMAP
 
-
-    #ifndef LIST_NO_CANARY
-        if (!checkLCanary(lst->data))
-            err |= VAR_DATA_CANARY_L_BAD;
-        if (!checkRCanary(lst->data, (lst->capacity + 1) * sizeof(LIST_ELEM_T)))
-            err |= VAR_DATA_CANARY_R_BAD;
-
-        if (!checkLCanary(lst->prev))
-            err |= VAR_DATA_CANARY_L_BAD;
-        if (!checkRCanary(lst->prev, (lst->capacity + 1) * sizeof(size_t)))
-            err |= VAR_DATA_CANARY_R_BAD;
-
-        if (!checkLCanary(lst->next))
-            err |= VAR_DATA_CANARY_L_BAD;
-        if (!checkRCanary(lst->next, (lst->capacity + 1) * sizeof(size_t)))
-            err |= VAR_DATA_CANARY_R_BAD;
-    #endif
-
-    if(err != 0){
-        err |= VAR_CORRUPT;
+    if (*ptr == nullptr && !zero){
+        char* new_mem = (char*)malloc(new_size);
+        if (new_mem == nullptr){
+            perror_log("error while allocating memory");
+            return false;
+        }
+        *ptr = new_mem + offset;
+        return true;
     }
-
-    return (varError_t)err;
-}
-
-static varError_t listError_dbg(List* lst){
-    #ifndef LIST_NO_PROTECT
-        return listError(lst);
-    #else
-        return VAR_NOERROR;
-    #endif
+    (void)old_size;
+    return listAllocOrResize(ptr, new_size, offset);
 }
 
-static void listTextDump(const List* lst){
-    printf_log("I |");
-    for (size_t i = 1; i <= lst->capacity; i++){
-        printf_log("%5d", i);
-    }
-    printf_log("\nD |");
-    for (size_t i = 1; i <= lst->capacity; i++){
-        printf_log("%5" LIST_ELEM_SPEC, lst->data[i]);
-    }
-    printf_log("\nP |");
-    for (size_t i = 1; i <= lst->capacity; i++){
-        printf_log("%5lu", lst->prev[i]);
-    }
-    printf_log("\nN |");
-    for (size_t i = 1; i <= lst->capacity; i++){
-        printf_log("%5lu", lst->next[i]);
-    }
-    printf_log("\n");
-
-    printf_log("list elements in order:\n");
-    size_t i = lst->next[0];
-    while (i != 0 && i < lst->capacity){
-        printf_log("%d ", lst->data[i]);
-        i = lst->next[i];
-    }
-    if (i != 0){
-        printf_log("...Bad pointer");
+void listStorageFree(void* ptr, size_t size, size_t offset){
+    char* mem = (char*)ptr - offset;
+#if LIST_USE_MREMAP
+    if (size >= LIST_MAP_MIN_SIZE){
+        munmap(mem, listPageRound(size));
+        return;
     }
-    printf_log("\n");
+#endif
+    (void)size;
+    free(mem);
 }
 
-static void listGraphDump(const List* lst){
-    #define COLOR_NORM_LINE    "\"#f0f0f0\""
-    #define COLOR_NORM_TXT     "\"#f0f0f0\""
-    #define COLOR_NORM_FILL    "\"#25252F\""
-    #define COLOR_VALID_LINE   "\"#dad0ac\""
-    #define COLOR_INVALID_LINE "\"#ff3e3e\""
-
-    #define COLOR_FREE_S_LINE  "\"#00b4ed\""
-    #define COLOR_FREE_S_FILL  "\"#00384a\""
-    #define COLOR_FREE_E_LINE  "\"#4aec6d\""
-    #define COLOR_FREE_E_FILL  "\"#053500\""
-
-
-    FILE* graph_file = fopen("graph.tmp", "w");
-    fprintf(graph_file, "digraph G{\n");
-    fprintf(graph_file, "rankdir=LR; bgcolor=\"#151515\";\n"
-                        "node[shape=rectangle, style=filled, fillcolor=" COLOR_NORM_FILL ", color=" COLOR_NORM_LINE ", fontcolor=" COLOR_NORM_TXT "]\n"
-                        "edge[weight=1, color=\"#f0f0f0\"]\n");
-
-    fprintf(graph_file, "\"N0\"[shape=diamond, label=\"[0]\", color=\"#6e00ff\"]\n");
-
-    //draw main nodes
-    for (size_t i = 1; i <= lst->capacity; i++){
-        const char* bgcolor   = COLOR_NORM_FILL;
-        const char* linecolor = COLOR_NORM_LINE;
-        if (lst->prev[i] == i){
-            linecolor = COLOR_FREE_S_LINE;
-            bgcolor   = COLOR_FREE_S_FILL;
-        }
-        if (i >= lst->fmem_end){
-            linecolor = COLOR_FREE_E_LINE;
-            bgcolor   = COLOR_FREE_E_FILL;
-        }
-
-        fprintf(graph_file, "\"N%d\"[shape=plaintext, style=solid, color = %s, "
-                "label=<<TABLE  BORDER=\"0\" CELLBORDER=\"1\" CELLSPACING=\"0\" BGCOLOR = %s>\n"
-                "<TR><TD>D: %" LIST_ELEM_SPEC "</TD></TR>\n"
-                "<TR><TD>P: %lu </TD></TR>\n"
-                "<TR><TD>N: %lu </TD></TR>\n"
-                "</TABLE>> ]\n"
-                , i, linecolor, bgcolor, lst->data[i], lst->prev[i], lst->next[i]);
+size_t listGrowthCapacity(const ListGrowth* g, size_t capacity, size_t need_cap, size_t max_cap){
+    size_t new_cap = 0;
+    if (g->hint >= need_cap){
+        new_cap = g->hint;
     }
-    for (size_t i = 0; i < lst->capacity; i++){
-        fprintf(graph_file, "\"N%d\"->", i);
+    else if (g->mode == LIST_GROW_STEP){
+        new_cap = capacity + g->value;
     }
-    fprintf(graph_file, "\"N%d\"[style=dotted, dir=none, weight=1000]\n", lst->capacity);
-
-    // draw index nodes
-    size_t drawn_size = lst->capacity;
-    if (lst->fmem_end == drawn_size + 1)
-        drawn_size = lst->fmem_end;
-
-    for (size_t i = 0; i <= drawn_size; i++){
-        fprintf(graph_file, "\"I%d\"[shape=plaintext, style=solid, label = \"[%d]\"]\n", i, i);
-    }
-    for (size_t i = 0; i < drawn_size; i++){
-        fprintf(graph_file, "\"I%d\"->", i, i, lst->data[i]);
-    }
-    fprintf(graph_file, "\"I%d\"[style=dotted, dir=none, weight=1000]\n", drawn_size);
-
-
-    for (int i = 0; i <= lst->capacity; i++){
-        fprintf(graph_file, "{rank=same; \"I%d\"; \"N%d\"}", i, i);
+    else{
+        new_cap = capacity / 100 * g->value + capacity % 100 * g->value / 100;
     }
 
-    //draw main edges
-    for(size_t i = 0; i < lst->fmem_end; i++){
-        fprintf(graph_file, "N%d->N%d[", i, lst->next[i]);
-
-        if (lst->prev[i] == i){
-            fprintf(graph_file, "color=" COLOR_FREE_S_LINE ", style=dashed");
-        }
-        else{
-            if(lst->prev[lst->next[i]] == i){
-                fprintf(graph_file, "dir=both, arrowtail=crow, color=" COLOR_VALID_LINE );
-            }
-            else{
-                fprintf(graph_file, "color=" COLOR_INVALID_LINE);
-            }
-        }
-        fprintf(graph_file, "]\n");
-
-        if (lst->next[lst->prev[i]] != i){
-            fprintf(graph_file, "N%d->N%d[arrowhead=crow, constraint=false", i, lst->prev[i]);
-            if (lst->prev[i] == i){
-                fprintf(graph_file, ",color=" COLOR_FREE_S_LINE ", style=dashed");
-            }
-            else{
-                fprintf(graph_file, ",color=" COLOR_INVALID_LINE);
-            }
-            fprintf(graph_file, "]\n");
-        }
+    if (new_cap < g->min_capacity){
+        new_cap = g->min_capacity;
     }
-
-    // draw pointer nodes
-    fprintf(graph_file, "HEAD[shape=ellipse, color=grey]\n");
-    fprintf(graph_file, "HEAD->N%d\n"                    , lst->next[0]);
-    fprintf(graph_file, "I%d->HEAD[style=invis]\n"       , lst->next[0]);
-    fprintf(graph_file, "{rank=same; \"N%d\"; \"HEAD\" }", lst->next[0]);
-
-    fprintf(graph_file, "TAIL[shape=ellipse, color=grey]\n");
-    fprintf(graph_file, "TAIL->N%d[arrowhead=crow]\n"    , lst->prev[0]);
-    fprintf(graph_file, "I%d->TAIL[style=invis]\n"       , lst->prev[0]);
-    fprintf(graph_file, "{rank=same; \"N%d\"; \"TAIL\" }", lst->prev[0]);
-
-    fprintf(graph_file, "FREE_STK[shape=ellipse, color=" COLOR_FREE_S_LINE "]\n");
-    fprintf(graph_file, "FREE_STK->N%d[color=" COLOR_FREE_S_LINE ", style=dashed]\n", lst->fmem_stack);
-    fprintf(graph_file, "I%d->FREE_STK[style=invis]\n"                              , lst->fmem_stack);
-    fprintf(graph_file, "{rank=same; \"N%d\"; \"FREE_STK\" }", lst->fmem_stack);
-
-    if (lst->fmem_end <= drawn_size){
-        fprintf(graph_file, "FREE_END[shape=ellipse, color=" COLOR_FREE_E_LINE "]\n");
-        fprintf(graph_file, "I%d->FREE_END[style=invis]\n"                              , lst->fmem_end);
-        fprintf(graph_file, "{rank=same; \"I%d\"; \"FREE_END\" }"                       , lst->fmem_end);
+    if (new_cap < need_cap){
+        new_cap = need_cap;
     }
-    if (lst->fmem_end <= lst->capacity){
-        fprintf(graph_file, "FREE_END->N%d[color=" COLOR_FREE_E_LINE ", style=dashed]\n", lst->fmem_end);
+    if (new_cap > max_cap){
+        new_cap = max_cap;
     }
-
-    fprintf(graph_file, "}");
-    fclose(graph_file);
-
-    char cmd_str[100] = "dot -Tpng graph.tmp -o";
-    embedNewDumpFile(cmd_str + strlen(cmd_str), "List_dump", ".png", "img");
-
-    system(cmd_str);
+    return new_cap;
 }
 
-void listDump(const List* lst, bool graph_dump){
-    hline_log();
-    varError_t err = listError(lst);
-    printf_log("List dump\n");
-    printf_log("    List at %p\n", lst);
-
-    bool ptr_ok = !(err & VAR_NULL || err & VAR_BAD);
-
-    printf_log("    Data: %p\n", lst->data);
-    printf_log("    Prev: %p\n", lst->prev);
-    printf_log("    Next: %p\n", lst->next);
-    printf_log("    Sort: %s\n", lst->sorted ? "true" : "false");
+uint64_t listClockNs(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-    if (err == VAR_NOERROR){
-       printf_log("    List ok\n", lst);
-    }
-    else {
-       printf_log("    ERRORS:\n", lst);
-    }
+void listCheckInit(ListCheckState* state, bool protect){
+    *state = {};
+    state->tier      = protect ? LIST_CHECK_SAMPLED : LIST_CHECK_OFF;
+    state->every     = 1;
+    state->countdown = 1;
+}
 
-    printBaseError_log((baseError_t) err);
-    if (!ptr_ok){
-        hline_log();
-        return;
+varError_t listCheckSetTier(ListCheckState* state, ListCheckTier tier, size_t every, size_t interval_ms){
+    if (tier < LIST_CHECK_OFF || tier > LIST_CHECK_PARANOID || every == 0){
+        return VAR_BADOP;
     }
+    state->tier         = tier;
+    state->every        = every;
+    state->countdown    = every;
+    state->interval_ns  = (uint64_t)interval_ms * 1000000;
+    state->last_full_ns = (interval_ms != 0) ? listClockNs() : 0;
+    return VAR_NOERROR;
+}
 
-    #ifndef LIST_NOCANARY
-        if (err & VAR_CANARY_L_BAD){
-            printf_log("     Left struct canary bad (%X | %X)\n", lst->leftcan , CANARY_L);
-        }
-        if (err & VAR_CANARY_R_BAD){
-            printf_log("     Right struct canary bad (%X | %X)\n", lst->rightcan , CANARY_R);
-        }
-    #endif
-    if (err & VAR_DATA_NULL){
-        printf_log("     Data pointer is null\n");
-        hline_log();
-        return;
+ListCheckTier listCheckDepth(ListCheckState* state){
+    if (state->tier != LIST_CHECK_SAMPLED){
+        return state->tier;
     }
-    if (err & VAR_DATA_BAD){
-        printf_log("     Data pointer is bad\n");
-        hline_log();
-        return;
+    bool full = (--state->countdown == 0);
+    if (!full && state->interval_ns != 0 && state->countdown % LIST_CHECK_CLOCK_STRIDE == 0){
+        full = listClockNs() - state->last_full_ns >= state->interval_ns;
     }
-
-    if (lst->data == nullptr){
-        printf_log("     List empty\n");
-        hline_log();
-        return;
+    if (!full){
+        return LIST_CHECK_CHEAP;
     }
-
-    if (ptr_ok){
-        printf_log("    Head: %lu Tail %lu Capacity %lu Size %lu\n", lst->next[0], lst->prev[0], lst->capacity, lst->size);
-        printf_log("    Free mem ptr: Stack: %lu Unused end: %lu\n", lst->fmem_stack, lst->fmem_end);
+    state->countdown = state->every;
+    if (state->interval_ns != 0){
+        state->last_full_ns = listClockNs();
     }
+    return LIST_CHECK_SAMPLED;
+}
 
-    if (err & VAR_BADSTATE){
-        printf_log("     (BAD) List in invalid state (indexes out of range)\n");
+void listCheckCount(ListCheckState* state, ListCheckTier depth, uint64_t start){
+    uint64_t* ns = nullptr;
+    switch (depth){
+        case LIST_CHECK_CHEAP:
+            state->stats.cheap_count++;
+            ns = &(state->stats.cheap_ns);
+            break;
+        case LIST_CHECK_PARANOID:
+            state->stats.deep_count++;
+            ns = &(state->stats.deep_ns);
+            break;
+        default:
+            state->stats.full_count++;
+            ns = &(state->stats.full_ns);
+            break;
+    }
+    if (state->timing){
+        *ns += listClockNs() - start;
     }
-    #ifndef LIST_NOCANARY
-        if (err & VAR_DATA_CANARY_L_BAD){
-            printf_log("     Left data canary bad (D%X-P%X-N%X | %X)\n",
-                        (canary_t*)(lst->data+1)[-1], (canary_t*)(lst->data+1)[-1], (canary_t*)(lst->data+1)[-1], CANARY_L);
-        }
-        if (err & VAR_DATA_CANARY_R_BAD){
-            size_t cap = lst->capacity;
-            printf_log("     Right data canary bad (D%X-P%X-N%X | %X)\n",
-                       (canary_t*)(lst->data+1)[-1], (canary_t*)(lst->data+1)[-1], (canary_t*)(lst->data+1)[-1], CANARY_R);
-        }
-    #endif
-
+}
 
-    if (graph_dump){
-        listGraphDump(lst);
+uint64_t listChecksum(uint64_t sum, const void* data, size_t len){
+    const uint64_t prime = 0x100000001b3ULL;
+    const unsigned char* p = (const unsigned char*)data;
+    for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t), p += sizeof(uint64_t)){
+        uint64_t word = 0;
+        memcpy(&word, p, sizeof(word));
+        sum = (sum ^ word) * prime;
     }
-    else{
-        listTextDump(lst);
+    for (; len > 0; len--, p++){
+        sum = (sum ^ *p) * prime;
     }
-    hline_log();
+    return sum;
 }
 
-varError_t listDtor(List* lst){
-    listCheckRet(lst, listError_dbg(lst));
-
-    for (size_t i = 0; i < lst->capacity; i++){
-        lst->data[i] = LIST_BADELEM;
+size_t listReleasePages(void* begin, size_t size){
+#ifdef _WIN32
+    SYSTEM_INFO info = {};
+    GetSystemInfo(&info);
+    size_t page = info.dwPageSize;
+#else
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    size_t from = ((size_t)begin + page - 1) / page * page;
+    size_t to   = ((size_t)begin + size) / page * page;
+    if (to <= from){
+        return 0;
     }
-    if (lst->data != nullptr)
-        free(listDataMemBegin(lst));
 
-    lst->data = (LIST_ELEM_T*)DESTRUCT_PTR;
-    lst->prev = (size_t*)DESTRUCT_PTR;
-    lst->next = (size_t*)DESTRUCT_PTR;
-    lst->capacity = -1;
-    #ifndef LIST_NO_PROTECT
-    (lst->info).status = VARSTATUS_DEAD;
-    #endif
-    return VAR_NOERROR;
-}
-
-static bool allocOrResize(void** ptr, size_t new_size , size_t offset){
-    void* new_mem = nullptr;
-    errno = 0;
-
-    if (*ptr != nullptr){
-        new_mem = (void*)(
-                            (char*)realloc((char*)(*ptr) - offset, new_size)
-                            + offset);
+#ifdef _WIN32
+    if (VirtualAlloc((void*)from, to - from, MEM_RESET, PAGE_READWRITE) == nullptr){
+        return 0;
     }
-    else{
-        new_mem = (LIST_ELEM_T*)(
-                            (char*)calloc(                         new_size, 1)
-                            + offset);
-    }
-    if (new_mem == nullptr){
-        perror_log("error while reallocating memory");
-        return false;
+#else
+    if (madvise((void*)from, to - from, MADV_DONTNEED) != 0){
+        perror_log("can not release list memory");
+        return 0;
     }
-    *ptr = new_mem;
-    return true;
+#endif
+    return to - from;
 }
 
-static void listReplaceDataCanary(List* lst){
-        #ifndef LIST_NO_CANARY
-            *((canary_t*)(lst->data + lst->capacity + 1)) = CANARY_R;
-            *((canary_t*)(lst->prev + lst->capacity + 1)) = CANARY_R;
-            *((canary_t*)(lst->next + lst->capacity + 1)) = CANARY_R;
+void listRenderGraph(const char* graph_file_name){
+    char cmd_str[200] = "";
+    int cmd_len = snprintf(cmd_str, sizeof(cmd_str), "dot -Tpng %s -o", graph_file_name);
+    embedNewDumpFile(cmd_str + cmd_len, "List_dump", ".png", "img");
 
-            *(canary_t*)((char*)(lst->data) - LIST_DATA_BEGIN_OFFSET    ) = CANARY_L;
-            *(canary_t*)((char*)(lst->prev) - LIST_DATA_PTR_BEGIN_OFFSET) = CANARY_L;
-            *(canary_t*)((char*)(lst->next) - LIST_DATA_PTR_BEGIN_OFFSET) = CANARY_L;
-        #endif
+    system(cmd_str);
 }
 
-varError_t listResize(List* lst, size_t new_capacity){
-    listCheckRet(lst, listError_dbg(lst));
-
-    if (new_capacity < lst->fmem_end - 1){
-        return VAR_BADOP;
+#define LIST_ELEM_INFO_DEF(_type, _bad, _spec)                              \
+    _type ListElemInfo<_type>::bad(){                                       \
+        return _bad;                                                         \
+    }                                                                        \
+    void ListElemInfo<_type>::print(char* buf, size_t buf_len, const _type& elem){\
+        snprintf(buf, buf_len, _spec, elem);                                 \
     }
 
-    if (allocOrResize((void**)&(lst->data), (new_capacity+1)*sizeof(LIST_ELEM_T) + LIST_DATA_SIZE_OFFSET , LIST_DATA_BEGIN_OFFSET) &&
-       allocOrResize((void**)&(lst->prev) , (new_capacity+1)*sizeof(size_t)      + LIST_DATA_SIZE_OFFSET , LIST_DATA_PTR_BEGIN_OFFSET) &&
-       allocOrResize((void**)&(lst->next) , (new_capacity+1)*sizeof(size_t)      + LIST_DATA_SIZE_OFFSET , LIST_DATA_PTR_BEGIN_OFFSET)
-       ) {
+LIST_ELEM_INFO_DEF(int      , 404            , "%d"  )
+LIST_ELEM_INFO_DEF(long long, 404            , "%lld")
+LIST_ELEM_INFO_DEF(size_t   , (size_t)-404   , "%lu" )
+LIST_ELEM_INFO_DEF(float    , NAN            , "%g"  )
+LIST_ELEM_INFO_DEF(double   , NAN            , "%lg" )
+LIST_ELEM_INFO_DEF(void*    , (void*)0xBAD   , "%p"  )
 
-        size_t t = lst->capacity;
-        lst->capacity = new_capacity;
+#undef LIST_ELEM_INFO_DEF
 
+//order-statistic index: treap with implicit keys, in-order == list order
 
-        #ifndef LIST_NO_PROTECT
-        for(size_t i = t + 1; i <= new_capacity; i++){
-            lst->data[i] = LIST_BADELEM;
-            lst->prev[i] = 0;
-            lst->next[i] = 0;
-        }
-        #endif
-
-        listReplaceDataCanary(lst);
-        return VAR_NOERROR;
-    }
-    else {
-        Error_log("%s", "error while resizing list\n");
-        return VAR_INTERR;
-    }
+static uint32_t listRankPrio(ListRankIndex* rank){
+    //splitmix64
+    uint64_t z = (rank->seed += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return (uint32_t)(z ^ (z >> 31));
 }
 
-static void listAddFreeMem(List* lst, size_t ind){
-    lst->next[ind] = lst->fmem_stack;
-    lst->prev[ind] = ind;
-    lst->fmem_stack = ind;
-    return;
+static void listRankUpdate(ListRankNode* t, size_t x){
+    t[x].count = 1 + t[t[x].left].count + t[t[x].right].count;
 }
 
-static size_t listGetFreeMem(List* lst){
-    if (lst->fmem_stack == 0){
-        if(lst->fmem_end <= lst->capacity)
-            return lst->fmem_end++;
-        else
-            return 0;
-    }
-    else {
-        size_t t = lst->fmem_stack;
-        lst->fmem_stack = lst->next[t];
-        return t;
-    }
+//! replaces child old_child of p (root if p == 0) with new_child
+static void listRankRelink(ListRankIndex* rank, size_t p, size_t old_child, size_t new_child){
+    ListRankNode* t = rank->nodes;
+    if (p == 0)
+        rank->root = new_child;
+    else if (t[p].left == old_child)
+        t[p].left = new_child;
+    else
+        t[p].right = new_child;
+    if (new_child != 0)
+        t[new_child].parent = p;
 }
 
-size_t listPushAfter(List* lst, size_t ind, LIST_ELEM_T elem, varError_t* err_ptr){
-    listCheckRetPtr(lst, err_ptr, 0);
-
-    if(ind >= lst->fmem_end)
-        return VAR_BADOP;
-    if(lst->prev != nullptr && lst->prev[ind] == ind)
-        return VAR_BADOP;
-
-    varError_t err = VAR_NOERROR;
-
-    size_t ni = listGetFreeMem(lst);
+//! rotates x above its parent
+static void listRankRotateUp(ListRankIndex* rank, size_t x){
+    ListRankNode* t = rank->nodes;
+    size_t p = t[x].parent;
+    size_t g = t[p].parent;
 
-    if (ni == 0){
-        int new_cap = lst->capacity * 2;
-        if (new_cap < 10){
-            new_cap = 10;
-        }
-
-        err = listResize(lst, new_cap);
-        if (err != VAR_NOERROR)
-            passError(varError_t, err);
-
-        ni = listGetFreeMem(lst);
-        if (ni == 0){
-            if (err_ptr){
-                *err_ptr = VAR_ERRUNK;
-                return 0;
-            }
-        }
+    if (t[p].left == x){
+        t[p].left = t[x].right;
+        if (t[x].right != 0)
+            t[t[x].right].parent = p;
+        t[x].right = p;
     }
-
-    if(ind != lst->prev[0]){
-        lst->sorted = false;
+    else{
+        t[p].right = t[x].left;
+        if (t[x].left != 0)
+            t[t[x].left].parent = p;
+        t[x].left = p;
     }
+    t[p].parent = x;
+    listRankRelink(rank, g, p, x);
 
-    lst->size++;
-
-    lst->data[ni] = elem;
-    lst->prev[ni] = ind;
-
-    lst->next[ni] = lst->next[ind];
-    lst->prev[lst->next[ind]] = ni;
-    lst->next[ind] = ni;
-
-    return ni;
+    t[x].count = t[p].count;
+    listRankUpdate(t, p);
 }
 
-varError_t listDeleteElem(List* lst, size_t ind){
-    listCheckRet(lst, listError_dbg(lst));
+void listRankInsertAfter(ListRankIndex* rank, size_t x, size_t y){
+    ListRankNode* t = rank->nodes;
+    t[x].left  = 0;
+    t[x].right = 0;
+    t[x].count = 1;
+    t[x].prio  = listRankPrio(rank);
 
-    if(ind >= lst->fmem_end)
-        return VAR_BADOP;
-    if(lst->prev == nullptr || lst->prev[ind] == ind)
-        return VAR_BADOP;
-
-    if (ind != lst->prev[0]){
-        lst->sorted = false;
+    size_t p = 0;
+    bool left = false;
+    if (y == 0){
+        p = rank->root;
+        left = true;
+        while (p != 0 && t[p].left != 0)
+            p = t[p].left;
     }
-
-    if (ind == 0 || ind >= lst->fmem_end || lst->prev[ind] == ind){
-        return VAR_BADOP;
+    else if (t[y].right == 0){
+        p = y;
+    }
+    else{
+        p = t[y].right;
+        left = true;
+        while (t[p].left != 0)
+            p = t[p].left;
     }
 
-    lst->size--;
-    lst->next[lst->prev[ind]] = lst->next[ind];
+    t[x].parent = p;
+    if (p == 0)
+        rank->root = x;
+    else if (left)
+        t[p].left = x;
+    else
+        t[p].right = x;
 
-    lst->prev[lst->next[ind]] = lst->prev[ind];
+    for (size_t i = p; i != 0; i = t[i].parent)
+        t[i].count++;
 
-    listAddFreeMem(lst, ind);
-    return VAR_NOERROR;
+    while (t[x].parent != 0 && t[t[x].parent].prio < t[x].prio)
+        listRankRotateUp(rank, x);
 }
 
-varError_t listSerialize(List* lst, size_t new_size){
-    listCheckRet(lst, listError_dbg(lst));
-    LIST_ELEM_T* new_data = nullptr;
-    size_t* new_prev = nullptr;
-    size_t* new_next = nullptr;
-
-    if (new_size < lst->size){
-        return VAR_BADOP;
+void listRankErase(ListRankIndex* rank, size_t x){
+    ListRankNode* t = rank->nodes;
+    while (t[x].left != 0 && t[x].right != 0){
+        size_t c = (t[t[x].left].prio > t[t[x].right].prio) ? t[x].left : t[x].right;
+        listRankRotateUp(rank, c);
     }
 
-    if (allocOrResize((void**)&(new_data), (new_size+1)*sizeof(LIST_ELEM_T) + LIST_DATA_SIZE_OFFSET , LIST_DATA_BEGIN_OFFSET)) {
-        int ni = 1;
-        int oi = lst->next[0];
-        while (ni <= lst->size && oi != 0){
-            new_data[ni] = lst->data[oi];
-            oi = lst->next[oi];
-            ni++;
-        }
-        if (ni <= lst->size || oi != 0){
-            free(new_data);
-            return VAR_CORRUPT;
-        }
+    size_t c = (t[x].left != 0) ? t[x].left : t[x].right;
+    size_t p = t[x].parent;
+    listRankRelink(rank, p, x, c);
+    for (size_t i = p; i != 0; i = t[i].parent)
+        t[i].count--;
 
-        if (allocOrResize((void**)(&new_prev), (new_size+1)*sizeof(size_t) + LIST_DATA_PTR_SIZE_OFFSET , LIST_DATA_PTR_BEGIN_OFFSET) &&
-            allocOrResize((void**)(&new_next), (new_size+1)*sizeof(size_t) + LIST_DATA_PTR_SIZE_OFFSET , LIST_DATA_PTR_BEGIN_OFFSET)   ) {
-
-            free(((char*)lst->data) - LIST_DATA_BEGIN_OFFSET);
-            free(((char*)lst->prev) - LIST_DATA_PTR_BEGIN_OFFSET);
-            free(((char*)lst->next) - LIST_DATA_PTR_BEGIN_OFFSET);
+    t[x].left   = 0;
+    t[x].right  = 0;
+    t[x].parent = 0;
+    t[x].count  = 0;
+}
 
-            lst->data = new_data;
-            lst->prev = new_prev;
-            lst->next = new_next;
-            lst->capacity = new_size;
-            lst->sorted = true;
+size_t listRankKth(const ListRankIndex* rank, size_t k){
+    const ListRankNode* t = rank->nodes;
+    size_t x = rank->root;
+    while (x != 0){
+        size_t l = t[t[x].left].count;
+        if (k <= l){
+            x = t[x].left;
+        }
+        else if (k == l + 1){
+            return x;
+        }
+        else{
+            k -= l + 1;
+            x = t[x].right;
+        }
+    }
+    return 0;
+}
 
-            lst->fmem_end = lst->size + 1;
-            lst->fmem_stack = 0;
+size_t listRankPos(const ListRankIndex* rank, size_t x){
+    const ListRankNode* t = rank->nodes;
+    if (t[x].count == 0)
+        return 0;
+    size_t pos = t[t[x].left].count + 1;
+    while (t[x].parent != 0){
+        size_t p = t[x].parent;
+        if (t[p].right == x)
+            pos += t[t[p].left].count + 1;
+        x = p;
+    }
+    return pos;
+}
 
-            for(int i = 1; i <= lst->size; i++){
-                new_prev[i  ] = i-1;
-                new_next[i-1] = i;
-            }
-            new_next[lst->size] = 0;
-            new_prev[0        ] = lst->size;
+void listRankSwapSlots(ListRankIndex* rank, size_t a, size_t b){
+    ListRankNode* t = rank->nodes;
+    #define SWAPPED_(_i) ((_i) == a ? b : ((_i) == b ? a : (_i)))
+
+    //tree neighbours of a and b (other than a and b) have to be relabeled once
+    size_t nb[6] = {};
+    size_t nb_cnt = 0;
+    size_t ends[2] = {a, b};
+    for (int e = 0; e < 2; e++){
+        size_t s = ends[e];
+        if (t[s].count == 0)
+            continue;
+        size_t cand[3] = {t[s].left, t[s].right, t[s].parent};
+        for (int c = 0; c < 3; c++){
+            size_t n = cand[c];
+            if (n == 0 || n == a || n == b)
+                continue;
+            bool seen = false;
+            for (size_t i = 0; i < nb_cnt; i++)
+                seen |= (nb[i] == n);
+            if (!seen)
+                nb[nb_cnt++] = n;
+        }
+    }
+    for (size_t i = 0; i < nb_cnt; i++){
+        t[nb[i]].left   = SWAPPED_(t[nb[i]].left);
+        t[nb[i]].right  = SWAPPED_(t[nb[i]].right);
+        t[nb[i]].parent = SWAPPED_(t[nb[i]].parent);
+    }
 
-            listReplaceDataCanary(lst);
-            return VAR_NOERROR;
+    ListRankNode ta = t[a];
+    t[a] = t[b];
+    t[b] = ta;
+    for (int e = 0; e < 2; e++){
+        size_t s = ends[e];
+        if (t[s].count == 0){
+            t[s].left = t[s].right = t[s].parent = 0;
+            continue;
         }
+        t[s].left   = SWAPPED_(t[s].left);
+        t[s].right  = SWAPPED_(t[s].right);
+        t[s].parent = SWAPPED_(t[s].parent);
     }
-    if (new_prev != nullptr)
-        free(new_prev);
-    if (new_next != nullptr)
-        free(new_next);
-    if (new_data != nullptr)
-        free(new_data);
-    return VAR_INTERR;
+    rank->root = SWAPPED_(rank->root);
+    #undef SWAPPED_
 }
 
+void listRankBuildAppend(ListRankIndex* rank, size_t x, size_t* rightmost){
+    ListRankNode* t = rank->nodes;
+    t[x].right = 0;
+    t[x].count = 0;
+    t[x].prio  = listRankPrio(rank);
+
+    //Cartesian tree by prio: nodes popped from right spine are finished subtrees
+    size_t last = 0;
+    size_t cur  = *rightmost;
+    while (cur != 0 && t[cur].prio < t[x].prio){
+        listRankUpdate(t, cur);
+        last = cur;
+        cur  = t[cur].parent;
+    }
+    t[x].left = last;
+    if (last != 0)
+        t[last].parent = x;
+    t[x].parent = cur;
+    if (cur != 0)
+        t[cur].right = x;
+    else
+        rank->root = x;
+    *rightmost = x;
+}
+
+void listRankBuildEnd(ListRankIndex* rank, size_t rightmost){
+    for (size_t cur = rightmost; cur != 0; cur = rank->nodes[cur].parent)
+        listRankUpdate(rank->nodes, cur);
+}
@@ -1,69 +1,587 @@
 #ifndef LIST_H_INCLUDED
 #define LIST_H_INCLUDED
 
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <functional>
+#include <algorithm>
+
 #include "lib/debug_utils.h"
 #include "lib/logging.h"
 
-#define LIST_ELEM_T int
-#define LIST_BADELEM 404
-#define LIST_ELEM_SPEC "d"
 //#define LIST_NOPROTECT
 //#define LIST_NOCANARY
 
+//! Storage layout of list slots
+enum ListLayout{
+    LIST_LAYOUT_SPLIT = 0, //!< three arrays: data, next, prev
+    LIST_LAYOUT_NODES = 1, //!< one array of {next, prev, data} nodes
+};
+
+//! Protection policies. Every List instantiation picks one of them at compile time:
+//! canary  - struct and data canaries
+//! varinfo - VarInfo with place of creation
+//! poison  - unused slots and destructed lists are filled with ListElemInfo<T>::bad()
+//! check   - list is checked on every public operation, how deep - runtime tier (listSetCheckTier)
+//! Fields of List stay in place for every policy, they are just not used when disabled.
+//! Policy also selects storage layout (see ListWithLayout) and
+//! type of next/prev links (see ListWithIndex)
+struct ListProtectPolicy{
+    static const bool canary  = true;
+    static const bool varinfo = true;
+    static const bool poison  = true;
+    static const bool check   = true;
+
+    static const ListLayout layout = LIST_LAYOUT_SPLIT;
+    typedef size_t index_t;
+};
+
+struct ListNoCanaryPolicy : ListProtectPolicy{
+    static const bool canary  = false;
+};
+
+struct ListNoProtectPolicy{
+    static const bool canary  = false;
+    static const bool varinfo = false;
+    static const bool poison  = false;
+    static const bool check   = false;
+
+    static const ListLayout layout = LIST_LAYOUT_SPLIT;
+    typedef size_t index_t;
+};
+
+//! Policy adapter: same protection as Base, different storage layout
+//! e.g. List<int, ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >
+template<typename Base, ListLayout Layout>
+struct ListWithLayout : Base{
+    static const ListLayout layout = Layout;
+};
+
+//! Policy adapter: narrow link index (uint32_t, uint16_t).
+//! Capacity of such list is limited by index range (listResize fails beyond it)
+//! e.g. List<int, ListWithIndex<ListNoProtectPolicy, uint32_t> >
+template<typename Base, typename Index>
+struct ListWithIndex : Base{
+    typedef Index index_t;
+};
+
+#if defined(LIST_NOPROTECT)
+    typedef ListNoProtectPolicy ListDefaultPolicy;
+#elif defined(LIST_NOCANARY)
+    typedef ListNoCanaryPolicy  ListDefaultPolicy;
+#else
+    typedef ListProtectPolicy   ListDefaultPolicy;
+#endif
+
+//! Runtime check tier of lists with Policy::check (see listSetCheckTier). Policies without
+//! check do no checks at all. Tier is read from the list, so only full checks
+//! (pointer probes of struct and arrays) catch lst pointing to bad memory
+enum ListCheckTier{
+    LIST_CHECK_OFF      = 0, //!< no checks
+    LIST_CHECK_CHEAP    = 1, //!< O(1) check: struct and array canaries, state fields. No pointer probes
+    LIST_CHECK_SAMPLED  = 2, //!< full listError every `every` calls or after interval, cheap check otherwise
+    LIST_CHECK_PARANOID = 3, //!< full listError and walk of all links on every call, O(size)
+};
+
+//! number of checks of every kind and time spent in them (time is measured only if enabled
+//! by listSetCheckTiming: clock reads cost more than cheap check)
+struct ListCheckStats{
+    uint64_t cheap_count;
+    uint64_t full_count;
+    uint64_t deep_count;   //!< paranoid link walks
+    uint64_t cheap_ns;
+    uint64_t full_ns;
+    uint64_t deep_ns;
+};
+
+struct ListCheckState{
+    ListCheckTier tier;
+    size_t   every;        //!< sampled: full check every this many calls
+    uint64_t interval_ns;  //!< sampled: full check if this much time passed since last one (0 - off)
+    bool     timing;
+    size_t   countdown;    //!< calls left to next sampled full check
+    uint64_t last_full_ns;
+    ListCheckStats stats;
+};
+
+//! sampled tier with interval reads clock once per this many calls
+static const size_t LIST_CHECK_CLOCK_STRIDE = 64;
+
+//! Capacity growth policy of a list (see listSetGrowth)
+enum ListGrowthMode{
+    LIST_GROW_FACTOR = 0, //!< capacity * value / 100
+    LIST_GROW_STEP   = 1, //!< capacity + value
+};
+
+struct ListGrowth{
+    ListGrowthMode mode;
+    size_t value;
+    size_t min_capacity; //!< capacity of first allocation
+    size_t hint;         //!< expected size from caller: list grows straight to it while it is enough (0 - none)
+};
+
+static const ListGrowth LIST_GROWTH_DEFAULT = {LIST_GROW_FACTOR, 200, 10, 0};
+
+//! storage arrays of at least this size are mapped pages grown by mremap (Linux), see listStorageResize
+static const size_t LIST_MAP_MIN_SIZE = 1 << 20;
+
+//! File-backed storage (see ListMapped.h, List_mapped.cpp)
+static const size_t LIST_MAP_MAX_ARRAYS = 3;
+
+struct ListMapping;
+
+//! list state kept in header of list file
+struct ListMapState{
+    uint64_t capacity;
+    uint64_t size;
+    uint64_t fmem_stack;
+    uint64_t fmem_end;
+    uint32_t sorted;
+    uint32_t clean; //!< 1 if file was closed by listDtor, 0 while it is open
+};
+
+//! storage arrays of list in file, must match for file to be opened
+struct ListMapLayout{
+    uint32_t layout;
+    uint32_t arrays;
+    uint32_t offset; //!< canary before every array
+    uint64_t elem_size[LIST_MAP_MAX_ARRAYS]; //!< of every array, unused ones may keep other sizes to be checked
+};
+
+//! Element type description: poison value and printing for dumps.
+//! Element must be trivially copyable (list memory is moved with realloc/mremap).
+//! Specialize it for your own types to get readable dumps.
+template<typename T>
+struct ListElemInfo{
+    static T bad(){
+        T elem;
+        memset(&elem, 0xBA, sizeof(elem));
+        return elem;
+    }
+    static void print(char* buf, size_t buf_len, const T& elem){
+        const uint8_t* bytes = (const uint8_t*)&elem;
+        size_t pos = 0;
+        for (size_t i = 0; i < sizeof(T) && i < 8 && pos + 3 < buf_len; i++){
+            pos += snprintf(buf + pos, buf_len - pos, "%02X", bytes[i]);
+        }
+        if (pos == 0 && buf_len > 0){
+            buf[0] = '\0';
+        }
+    }
+};
+
+#define LIST_ELEM_INFO_DECL(_type)                                    \
+    template<>                                                         \
+    struct ListElemInfo<_type>{                                        \
+        static _type bad();                                            \
+        static void print(char* buf, size_t buf_len, const _type& elem);\
+    };
+
+LIST_ELEM_INFO_DECL(int)
+LIST_ELEM_INFO_DECL(long long)
+LIST_ELEM_INFO_DECL(size_t)
+LIST_ELEM_INFO_DECL(float)
+LIST_ELEM_INFO_DECL(double)
+LIST_ELEM_INFO_DECL(void*)
+
+#undef LIST_ELEM_INFO_DECL
+
+//! Element hash for value index (see listHashIndexEnable). Default hashes bytes of element,
+//! specialize it for types whose equal values may differ in bytes (padding, pointers to data)
+template<typename T>
+struct ListElemHash{
+    static uint64_t hash(const T& elem){
+        const uint8_t* bytes = (const uint8_t*)&elem;
+        uint64_t h = 0xCBF29CE484222325ull;
+        for (size_t i = 0; i < sizeof(T); i++){
+            h = (h ^ bytes[i]) * 0x100000001B3ull;
+        }
+        return h ^ (h >> 29);
+    }
+};
+
+//-0.0 == 0.0, so floating point values are normalized before hashing
+template<>
+struct ListElemHash<double>{
+    static uint64_t hash(double elem){
+        if (elem == 0)
+            elem = 0;
+        uint64_t bits = 0;
+        memcpy(&bits, &elem, sizeof(bits));
+        bits *= 0x9E3779B97F4A7C15ull;
+        return bits ^ (bits >> 32);
+    }
+};
+template<>
+struct ListElemHash<float>{
+    static uint64_t hash(float elem){
+        return ListElemHash<double>::hash(elem);
+    }
+};
+
+static const size_t LIST_ELEM_STR_LEN = 32;
+static const size_t LIST_RANK_WALK_MAX = 32; //!< cursor walks this far before using rank index
+static const size_t LIST_SHRINK_RATIO        = 4;    //!< auto shrink starts when size < capacity / ratio
+static const size_t LIST_SHRINK_MIN_CAPACITY = 1024; //!< auto shrink never goes below this
+static const size_t LIST_SHRINK_BUDGET       = 4;    //!< compaction work per mutation while shrinking, times capacity / size
+
+template<typename T, typename Index = size_t>
+struct ListNode{
+    Index next;
+    Index prev;
+    T     data;
+};
+
+//! Node of optional order-statistic index (treap in list order, see listRankIndexEnable).
+//! Indexed by list slot, 0 is null node
+struct ListRankNode{
+    size_t left;
+    size_t right;
+    size_t parent;
+    size_t count;  //!< nodes in subtree, 0 for slots not in tree
+    uint32_t prio;
+};
+
+struct ListRankIndex{
+    ListRankNode* nodes; //!< nullptr if index is disabled
+    size_t root;
+    uint64_t seed;
+};
+
+//! Optional value -> node index (see listHashIndexEnable). Open addressing table holds
+//! one node per distinct value, other nodes with equal value are chained through chain array
+struct ListHashIndex{
+    size_t* table;      //!< nullptr if index is disabled. 0 - empty cell
+    size_t  table_size; //!< power of 2, at least twice the capacity
+    size_t* chain;      //!< chain[2*i] - next, chain[2*i + 1] - prev node with value of node i
+};
 
+//! Slot invariant (every policy): slot 0 < i < fmem_end is free if and only if prev[i] == i
+//! (except sentinels of empty PoolLists), so liveness of an index is checked in O(1) and code
+//! scanning storage needs no free stack walk. Every path that frees slots marks them
+template<typename T, typename Policy = ListDefaultPolicy>
 struct List{
-    #ifndef LIST_NOCANARY
-        canary_t leftcan;
-    #endif
-    #ifndef LIST_NOPROTECT
-        VarInfo info;
-    #endif
+    typedef T      elem_t;
+    typedef Policy policy_t;
+    typedef typename Policy::index_t   index_t;
+    typedef ListNode<T, index_t>       node_t;
+
+    canary_t leftcan;
+    VarInfo info;
+
     size_t capacity;
     size_t size;
 
-    LIST_ELEM_T* data;
-    size_t*      next;
-    size_t*      prev;
+    //LIST_LAYOUT_SPLIT storage
+    T*       data;
+    index_t* next;
+    index_t* prev;
+    //LIST_LAYOUT_NODES storage
+    node_t*  nodes;
 
     size_t fmem_stack;
     size_t fmem_end;
 
     bool sorted = true;
-    #ifndef LIST_NOCANARY
-        canary_t rightcan;
-    #endif
+
+    size_t compact_pos;    //!< 0 if no compaction is running (see listCompactStep)
+    size_t compact_budget; //!< compaction work done by every mutation
+    bool   auto_shrink;    //!< see listSetAutoShrink
+    ListGrowth growth;
+    ListMapping* map; //!< file storage is mapped from (see ListMapped.h), nullptr for heap storage
+
+    ListRankIndex rank;
+    ListHashIndex hash;
+
+    bool pool; //!< slot storage of ListPool: each PoolList is its own ring, link walk does not apply
+
+    //! changed by checks of const lists too (counters, sampling), so it is not thread-safe
+    mutable ListCheckState check;
+
+    canary_t rightcan;
 };
 
+//! slot accessors, work for any layout
+template<typename T, typename Policy>
+inline T& listData(List<T, Policy>* lst, size_t ind){
+    if (Policy::layout == LIST_LAYOUT_NODES)
+        return lst->nodes[ind].data;
+    return lst->data[ind];
+}
+template<typename T, typename Policy>
+inline const T& listData(const List<T, Policy>* lst, size_t ind){
+    if (Policy::layout == LIST_LAYOUT_NODES)
+        return lst->nodes[ind].data;
+    return lst->data[ind];
+}
+
+template<typename T, typename Policy>
+inline typename Policy::index_t& listNext(List<T, Policy>* lst, size_t ind){
+    if (Policy::layout == LIST_LAYOUT_NODES)
+        return lst->nodes[ind].next;
+    return lst->next[ind];
+}
+template<typename T, typename Policy>
+inline size_t listNext(const List<T, Policy>* lst, size_t ind){
+    if (Policy::layout == LIST_LAYOUT_NODES)
+        return lst->nodes[ind].next;
+    return lst->next[ind];
+}
+
+template<typename T, typename Policy>
+inline typename Policy::index_t& listPrev(List<T, Policy>* lst, size_t ind){
+    if (Policy::layout == LIST_LAYOUT_NODES)
+        return lst->nodes[ind].prev;
+    return lst->prev[ind];
+}
+template<typename T, typename Policy>
+inline size_t listPrev(const List<T, Policy>* lst, size_t ind){
+    if (Policy::layout == LIST_LAYOUT_NODES)
+        return lst->nodes[ind].prev;
+    return lst->prev[ind];
+}
+
+//! max capacity allowed by link index type
+template<typename T, typename Policy>
+constexpr size_t listMaxCapacity(const List<T, Policy>*){
+    return (size_t)(typename Policy::index_t)(-1) - 1;
+}
+
+//! true if list has allocated storage
+template<typename T, typename Policy>
+inline bool listHasMem(const List<T, Policy>* lst){
+    if (Policy::layout == LIST_LAYOUT_NODES)
+        return lst->nodes != nullptr;
+    return lst->data != nullptr;
+}
+
 #ifdef listCtor
-    #error redefinition of internal macro stackCtor
-#endif
-#ifndef LIST_NO_PROTECT
-    #define listCtor(_lst)      \
-        if (listCtor_(_lst)){  \
-            (_lst)->info = varInfoInit(_lst); \
-        }                       \
-        else {                  \
-            Error_log("%s", "bad ptr passed to constructor\n");\
-        }
-#else
-    #define listCtor(__stk)    \
-            listCtor_(__stk);
+    #error redefinition of internal macro listCtor
 #endif
+#define listCtor(_lst)      \
+    if (listCtor_(_lst)){  \
+        listSetInfo(_lst, varInfoInit(_lst)); \
+    }                       \
+    else {                  \
+        Error_log("%s", "bad ptr passed to constructor\n");\
+    }
+
+template<typename T, typename Policy>
+bool listCtor_(List<T, Policy>* lst);
+
+template<typename T, typename Policy>
+void listSetInfo(List<T, Policy>* lst, VarInfo info);
+
+template<typename T, typename Policy>
+varError_t listError(const List<T, Policy>* lst);
+
+template<typename T, typename Policy>
+void listDump(const List<T, Policy>* lst, bool graph_dump = true);
+
+template<typename T, typename Policy>
+varError_t listDtor(List<T, Policy>* lst);
+
+template<typename T, typename Policy>
+varError_t listResize(List<T, Policy>* lst, size_t new_capacity);
+
+//! sets how capacity grows when list is full (default LIST_GROWTH_DEFAULT - doubling from 10)
+template<typename T, typename Policy>
+void listSetGrowth(List<T, Policy>* lst, ListGrowth growth);
+
+//! expected size of list: next growth goes straight to it instead of several steps
+template<typename T, typename Policy>
+void listSetGrowthHint(List<T, Policy>* lst, size_t expected_size);
 
-bool listCtor_(List* lst);
+template<typename T, typename Policy>
+size_t listPushAfter(List<T, Policy>* lst, size_t ind, T elem, varError_t* err_ptr);
 
-varError_t listError(const List* lst);
+//! inserts n elements from src after ind in one operation.
+//! New nodes are placed into one physical run at unused end of storage if it is long enough,
+//! else into free slots (list grows only if it has less than size + n slots).
+//! Returns index of first inserted node (0 on error)
+template<typename T, typename Policy>
+size_t listInsertRangeAfter(List<T, Policy>* lst, size_t ind, const T* src, size_t n, varError_t* err_ptr);
+
+template<typename T, typename Policy>
+varError_t listDeleteElem(List<T, Policy>* lst, size_t ind);
+
+//! deletes nodes first..last (inclusive, in list order). Relinks in O(1) and
+//! moves the whole run to free stack at once. count is number of nodes in range,
+//! pass 0 to have it counted. Protected lists always verify the range (O(range))
+template<typename T, typename Policy>
+varError_t listEraseRange(List<T, Policy>* lst, size_t first, size_t last, size_t count = 0);
+
+//! moves nodes first..last to position after dst_pos in O(1)
+//! (dst_pos must not be inside the range)
+template<typename T, typename Policy>
+varError_t listSplice(List<T, Policy>* lst, size_t dst_pos, size_t first, size_t last);
+
+//! removes all elements, keeps capacity
+template<typename T, typename Policy>
+varError_t listClear(List<T, Policy>* lst);
+
+//! starts incremental compaction (physical order -> logical order).
+//! Every following mutation does auto_budget units of compaction work (0 - none)
+template<typename T, typename Policy>
+varError_t listCompactBegin(List<T, Policy>* lst, size_t auto_budget = 0);
+
+//! moves up to budget nodes toward physical == logical order, starts compaction if needed.
+//! List stays usable between steps. Returns true when compaction is finished (sorted is set)
+template<typename T, typename Policy>
+bool listCompactStep(List<T, Policy>* lst, size_t budget, varError_t* err_ptr = nullptr);
+
+//! puts nodes to physical == logical order in place (cycle-following swaps, O(size) time,
+//! O(1) extra memory), then resizes storage to new_size
+template<typename T, typename Policy>
+varError_t listSerialize(List<T, Policy>* lst, size_t new_size);
+
+//! compacts and truncates storage to size elements (listSerialize(lst, lst->size))
+template<typename T, typename Policy>
+varError_t listShrinkToFit(List<T, Policy>* lst);
+
+//! Auto shrink: when a deletion leaves size < capacity / LIST_SHRINK_RATIO, incremental
+//! compaction is started (or finished at once for sorted lists), and when it is done
+//! capacity is cut to 2 * size. Growth doubles capacity only when it is full, so the
+//! list does not oscillate. Moves nodes like compaction does: indexes held by caller
+//! are invalidated by deletions. Off by default
+template<typename T, typename Policy>
+void listSetAutoShrink(List<T, Policy>* lst, bool enable);
+
+//! sets check tier (lists with Policy::check only). every and interval_ms are used by LIST_CHECK_SAMPLED:
+//! full check is done every `every` calls, and also when interval_ms passed since last one (0 - off).
+//! Default is LIST_CHECK_SAMPLED with every = 1: full check on every call
+template<typename T, typename Policy>
+varError_t listSetCheckTier(List<T, Policy>* lst, ListCheckTier tier, size_t every = 1, size_t interval_ms = 0);
+
+//! turns on measuring time spent in checks (see ListCheckStats)
+template<typename T, typename Policy>
+void listSetCheckTiming(List<T, Policy>* lst, bool enable);
+
+template<typename T, typename Policy>
+ListCheckStats listCheckStats(const List<T, Policy>* lst);
+
+template<typename T, typename Policy>
+void listResetCheckStats(List<T, Policy>* lst);
+
+//! returns pages of free slots to the OS (madvise(MADV_DONTNEED) / MEM_RESET), keeps capacity.
+//! Never used end of storage is released in all arrays, free runs in the middle -
+//! in data array of LIST_LAYOUT_SPLIT lists (links of free slots are still in use).
+//! Returns number of released bytes
+template<typename T, typename Policy>
+size_t listReleaseFreeMem(List<T, Policy>* lst);
+
+//! stable sort by value, cmp(a, b) is "a goes before b". Link-level merge sort (O(n log n),
+//! no allocation), then listSerialize, so list ends up sorted in storage too.
+//! See listSortParallel (ListParallel.h) for large lists
+template<typename T, typename Policy, typename Cmp = std::less<T>>
+varError_t listSort(List<T, Policy>* lst, Cmp cmp = Cmp());
+
+//! merges src into dst, both must be sorted by cmp (equal elements of dst go first).
+//! Lists do not share storage, so this copies: elements of src are copied to the unused end
+//! of dst storage (free slots of dst are not reused), then both chains are relinked in one
+//! pass. O(dst->size + src->size) time, plus one resize of dst if fmem_end - 1 + src->size
+//! exceeds its capacity. Indexes of dst stay valid; src is cleared (keeps its capacity),
+//! its indexes do not refer to the moved elements. To move nodes without copying keep the
+//! lists in one ListPool and use poolListSplice
+template<typename T, typename Policy, typename Cmp = std::less<T>>
+varError_t listMerge(List<T, Policy>* dst, List<T, Policy>* src, Cmp cmp = Cmp());
+
+//! Positional access. Positions are 1..size in list order.
+//! O(1) when list is sorted, otherwise walks from the nearest end (or cursor)
+
+//! index of node at position pos, 0 if pos is out of range
+template<typename T, typename Policy>
+size_t listIndexOf(const List<T, Policy>* lst, size_t pos);
+
+//! element at position pos
+template<typename T, typename Policy>
+T listGetAt(const List<T, Policy>* lst, size_t pos, varError_t* err_ptr = nullptr);
+
+//! position of node ind, 0 if ind is not a node
+template<typename T, typename Policy>
+size_t listRankOf(const List<T, Policy>* lst, size_t ind);
+
+//! builds order-statistic index in O(size). While enabled, positional access (listIndexOf,
+//! listRankOf, listCursorSeek) is O(log n) on unsorted lists, and every inserted or removed
+//! node costs O(log n) more. Takes sizeof(ListRankNode) per slot
+template<typename T, typename Policy>
+varError_t listRankIndexEnable(List<T, Policy>* lst);
+
+template<typename T, typename Policy>
+void listRankIndexDisable(List<T, Policy>* lst);
+
+//! builds value index in O(size). While enabled, listHashFind is O(1) and every inserted,
+//! removed or moved node costs O(1) more. Elements must not be changed through listData
+//! while index is enabled: call listHashIndexEnable again to rebuild it after that
+template<typename T, typename Policy>
+varError_t listHashIndexEnable(List<T, Policy>* lst);
+
+template<typename T, typename Policy>
+void listHashIndexDisable(List<T, Policy>* lst);
+
+//! index of a node equal to elem (with value index: in O(1), not necessarily the first one), 0 if none
+template<typename T, typename Policy>
+size_t listHashFind(const List<T, Policy>* lst, T elem);
+
+//! remembers last (position, index) pair, so access to nearby positions costs O(distance).
+//! {0, 0} is a valid cursor (at sentinel). Any list change (compaction steps too)
+//! invalidates it: start over from {0, 0}
+struct ListCursor{
+    size_t pos;
+    size_t ind;
+};
 
-void listDump(const List* lst, bool graph_dump = true);
+//! moves cursor to position pos, returns index of node there (0 if pos is out of range)
+template<typename T, typename Policy>
+size_t listCursorSeek(const List<T, Policy>* lst, ListCursor* cur, size_t pos);
 
-varError_t listDtor(List* lst);
+//non-template helpers (List.cpp)
+bool listAllocOrResize(void** ptr, size_t new_size, size_t offset);
+//! listAllocOrResize for list storage arrays: arrays of LIST_MAP_MIN_SIZE bytes and more are
+//! mapped pages and are grown with mremap (no copy) on Linux. Memory is zeroed only if zero is set
+//! (mapped pages are always zero). Arrays from it must be freed with listStorageFree
+bool listStorageResize(void** ptr, size_t old_size, size_t new_size, size_t offset, bool zero);
+void listStorageFree(void* ptr, size_t size, size_t offset);
 
-varError_t listResize(List* lst, size_t new_capacity);
+//! file-backed storage helpers (List_mapped.cpp). listMapOpen creates file with state->capacity
+//! slots if it is empty, otherwise checks layout and reads state. arrays get storage array pointers
+ListMapping* listMapOpen(const char* path, const ListMapLayout* layout, ListMapState* state,
+                         void** arrays, varError_t* err_ptr);
+bool listMapResize(ListMapping* map, const ListMapLayout* layout, size_t old_capacity, size_t new_capacity, void** arrays);
+bool listMapSync  (ListMapping* map, const ListMapState* state);
+void listMapClose (ListMapping* map);
+//! capacity growth policy g gives to storage of capacity slots that needs need_cap slots
+//! (at least need_cap unless it is over max_cap)
+size_t listGrowthCapacity(const ListGrowth* g, size_t capacity, size_t need_cap, size_t max_cap);
+//! continues 64-bit FNV-1a checksum sum with len bytes (8-byte words, then bytes of tail).
+//! Splitting data into parts gives same sum if every part but last is a multiple of 8 bytes
+uint64_t listChecksum(uint64_t sum, const void* data, size_t len);
+//! monotonic clock for check timing, ns
+uint64_t listClockNs();
+//! check state of new list: full check on every call if protect, else no checks
+void listCheckInit(ListCheckState* state, bool protect);
+varError_t listCheckSetTier(ListCheckState* state, ListCheckTier tier, size_t every, size_t interval_ms);
+//! depth of next check by tier (sampled tier gives LIST_CHECK_SAMPLED for full check), advances sampling
+ListCheckTier listCheckDepth(ListCheckState* state);
+//! counts check of given depth started at start (listClockNs, used if timing is on)
+void listCheckCount(ListCheckState* state, ListCheckTier depth, uint64_t start);
+//! tells OS that whole pages inside [begin, begin + size) are not needed, returns released bytes
+size_t listReleasePages(void* begin, size_t size);
 
-size_t listPushAfter(List* lst, size_t ind, LIST_ELEM_T elem, varError_t* err_ptr);
+void listRenderGraph(const char* graph_file_name);
 
-varError_t listDeleteElem(List* lst, size_t ind);
+//! order-statistic index helpers: x is inserted as in-order successor of y (0 - at front)
+void listRankInsertAfter(ListRankIndex* rank, size_t x, size_t y);
+void listRankErase      (ListRankIndex* rank, size_t x);
+size_t listRankKth(const ListRankIndex* rank, size_t k);
+size_t listRankPos(const ListRankIndex* rank, size_t x);
+//! relabels tree nodes of slots a and b (either may be not in tree)
+void listRankSwapSlots  (ListRankIndex* rank, size_t a, size_t b);
+//! builds tree from nodes appended in list order in O(n)
+void listRankBuildAppend(ListRankIndex* rank, size_t x, size_t* rightmost);
+void listRankBuildEnd   (ListRankIndex* rank, size_t rightmost);
 
-varError_t listSerialize(List* lst, size_t new_size);
+#include "List_impl.h"
 
 #endif // LIST_H_INCLUDED
@@ -0,0 +1,325 @@
+#ifndef LISTBATCH_H_INCLUDED
+#define LISTBATCH_H_INCLUDED
+
+//! Batched mutations (listBatchBegin .. listBatchCommit). List is checked once at begin
+//! and once at commit, operations in between only check their own arguments.
+//! Every operation is applied at once and writes an undo record; first failed operation
+//! makes commit roll whole batch back (listBatchRollback does it on request).
+//! Compaction and shrinking steps are put off until commit, so slot indexes in undo log stay valid.
+//! Other list functions must not be called while batch is open.
+
+#include "List.h"
+
+enum ListBatchOp{
+    LIST_BATCH_PUSH,      //!< node was taken from free stack
+    LIST_BATCH_PUSH_END,  //!< node was taken from unused end
+    LIST_BATCH_DELETE,
+    LIST_BATCH_MOVE,
+};
+
+template<typename Policy>
+struct ListBatchUndo{
+    typename Policy::index_t node;
+    typename Policy::index_t prev; //!< node it was after (delete, move)
+    uint8_t op;
+};
+
+template<typename T, typename Policy = ListDefaultPolicy>
+struct ListBatch{
+    List<T, Policy>* lst;
+    ListBatchUndo<Policy>* log;
+    size_t log_size;
+    size_t log_capacity;
+    T* deleted;          //!< elements of deleted nodes, in order of LIST_BATCH_DELETE records
+    size_t deleted_size;
+    size_t deleted_capacity;
+
+    varError_t err;      //!< error of first failed operation
+    bool sorted;
+    size_t compact_pos;
+};
+
+//! starts batch, list gets room for reserve new nodes now (no resizes in batch until they are used)
+template<typename T, typename Policy>
+varError_t listBatchBegin(List<T, Policy>* lst, ListBatch<T, Policy>* batch, size_t reserve = 0){
+    if (batch == nullptr){
+        return VAR_BADOP;
+    }
+    //batch that failed to begin is closed: commit and rollback return VAR_BADOP for it
+    batch->lst          = nullptr;
+    batch->log          = nullptr;
+    batch->log_size     = 0;
+    batch->log_capacity = 0;
+    batch->deleted          = nullptr;
+    batch->deleted_size     = 0;
+    batch->deleted_capacity = 0;
+    batch->err          = VAR_NOERROR;
+
+    listCheckRet(lst, listError_dbg(lst));
+
+    //slots freed during compaction are not on free stack, only unused end is sure to be free then
+    size_t used = (lst->compact_pos != 0) ? lst->fmem_end - 1 : lst->size;
+    if (reserve > listMaxCapacity(lst) - used){
+        return VAR_BADOP;
+    }
+    if (used + reserve > lst->capacity || !listHasMem(lst)){
+        varError_t err = listResize_(lst, listGrowCapacity(lst, used + reserve));
+        if (err != VAR_NOERROR){
+            return err;
+        }
+    }
+
+    batch->lst          = lst;
+    batch->sorted       = lst->sorted;
+    batch->compact_pos  = lst->compact_pos;
+    return VAR_NOERROR;
+}
+
+//! makes room for one more record (and deleted element), false if memory can not be allocated
+template<typename T, typename Policy>
+static bool listBatchReserve(ListBatch<T, Policy>* batch, bool with_elem){
+    if (batch->log_size == batch->log_capacity){
+        size_t new_cap = (batch->log_capacity == 0) ? 16 : 2 * batch->log_capacity;
+        void* mem = realloc(batch->log, new_cap * sizeof(ListBatchUndo<Policy>));
+        if (mem == nullptr){
+            return false;
+        }
+        batch->log = (ListBatchUndo<Policy>*)mem;
+        batch->log_capacity = new_cap;
+    }
+    if (with_elem && batch->deleted_size == batch->deleted_capacity){
+        size_t new_cap = (batch->deleted_capacity == 0) ? 16 : 2 * batch->deleted_capacity;
+        void* mem = realloc(batch->deleted, new_cap * sizeof(T));
+        if (mem == nullptr){
+            return false;
+        }
+        batch->deleted = (T*)mem;
+        batch->deleted_capacity = new_cap;
+    }
+    return true;
+}
+
+template<typename T, typename Policy>
+static void listBatchLog(ListBatch<T, Policy>* batch, ListBatchOp op, size_t node, size_t prev){
+    ListBatchUndo<Policy> rec = {};
+    rec.node = (typename Policy::index_t)node;
+    rec.prev = (typename Policy::index_t)prev;
+    rec.op   = (uint8_t)op;
+    batch->log[batch->log_size++] = rec;
+}
+
+template<typename T, typename Policy>
+static varError_t listBatchFail(ListBatch<T, Policy>* batch, varError_t err){
+    if (batch->err == VAR_NOERROR){
+        batch->err = err;
+    }
+    return err;
+}
+
+//links free slot x after live node ind
+template<typename T, typename Policy>
+static void listBatchLink(List<T, Policy>* lst, size_t x, size_t ind){
+    listPrev(lst, x) = ind;
+    listNext(lst, x) = listNext(lst, ind);
+    listPrev(lst, listNext(lst, ind)) = x;
+    listNext(lst, ind) = x;
+    lst->size++;
+
+    if (lst->rank.nodes != nullptr){
+        listRankInsertAfter(&(lst->rank), x, ind);
+    }
+    if (lst->hash.table != nullptr){
+        listHashInsert(lst, x);
+    }
+}
+
+template<typename T, typename Policy>
+static void listBatchUnlink(List<T, Policy>* lst, size_t x){
+    if (lst->rank.nodes != nullptr){
+        listRankErase(&(lst->rank), x);
+    }
+    if (lst->hash.table != nullptr){
+        listHashErase(lst, x);
+    }
+    listNext(lst, listPrev(lst, x)) = listNext(lst, x);
+    listPrev(lst, listNext(lst, x)) = listPrev(lst, x);
+    lst->size--;
+}
+
+//! listPushAfter in batch
+template<typename T, typename Policy>
+size_t listBatchPushAfter(ListBatch<T, Policy>* batch, size_t ind, T elem, varError_t* err_ptr = nullptr){
+    List<T, Policy>* lst = batch->lst;
+    varError_t err = VAR_NOERROR;
+
+    if (ind >= lst->fmem_end || (ind != 0 && listPrev(lst, ind) == ind)){
+        err = VAR_BADOP;
+    }
+    else if (!listBatchReserve(batch, false)){
+        err = VAR_INTERR;
+    }
+    bool from_end = (lst->fmem_stack == 0);
+    size_t x = (err == VAR_NOERROR) ? listGetFreeMem(lst) : 0;
+    if (err == VAR_NOERROR && x == 0){
+        //reserve was too small
+        err = (lst->capacity >= listMaxCapacity(lst)) ? VAR_BADOP : listResize_(lst, listGrowCapacity(lst, lst->capacity + 1));
+        from_end = (lst->fmem_stack == 0);
+        x = (err == VAR_NOERROR) ? listGetFreeMem(lst) : 0;
+    }
+    if (x == 0){
+        err = listBatchFail(batch, (err == VAR_NOERROR) ? VAR_ERRUNK : err);
+        if (err_ptr)
+            *err_ptr = err;
+        return 0;
+    }
+
+    listBatchLog(batch, from_end ? LIST_BATCH_PUSH_END : LIST_BATCH_PUSH, x, ind);
+    if (ind != listPrev(lst, 0) || x != lst->size + 1){
+        lst->sorted = false;
+    }
+    listCompactTouch(lst, ind + 1);
+    listData(lst, x) = elem;
+    listBatchLink(lst, x, ind);
+    if (err_ptr)
+        *err_ptr = VAR_NOERROR;
+    return x;
+}
+
+//! listDeleteElem in batch
+template<typename T, typename Policy>
+varError_t listBatchDelete(ListBatch<T, Policy>* batch, size_t ind){
+    List<T, Policy>* lst = batch->lst;
+
+    if (ind == 0 || ind >= lst->fmem_end || listPrev(lst, ind) == ind){
+        return listBatchFail(batch, VAR_BADOP);
+    }
+    if (!listBatchReserve(batch, true)){
+        return listBatchFail(batch, VAR_INTERR);
+    }
+
+    listBatchLog(batch, LIST_BATCH_DELETE, ind, listPrev(lst, ind));
+    batch->deleted[batch->deleted_size++] = listData(lst, ind);
+    if (ind != listPrev(lst, 0)){
+        lst->sorted = false;
+    }
+    listBatchUnlink(lst, ind);
+    if (Policy::poison){
+        listData(lst, ind) = ListElemInfo<T>::bad();
+    }
+    listAddFreeMem(lst, ind);
+    listCompactTouch(lst, ind);
+    return VAR_NOERROR;
+}
+
+//! moves node ind to be after node dst (0 - to the front)
+template<typename T, typename Policy>
+varError_t listBatchMoveAfter(ListBatch<T, Policy>* batch, size_t ind, size_t dst){
+    List<T, Policy>* lst = batch->lst;
+
+    if (ind == 0 || ind >= lst->fmem_end || listPrev(lst, ind) == ind || ind == dst ||
+        dst >= lst->fmem_end || (dst != 0 && listPrev(lst, dst) == dst)){
+        return listBatchFail(batch, VAR_BADOP);
+    }
+    if (!listBatchReserve(batch, false)){
+        return listBatchFail(batch, VAR_INTERR);
+    }
+    if (listPrev(lst, ind) == dst){
+        return VAR_NOERROR;
+    }
+
+    listBatchLog(batch, LIST_BATCH_MOVE, ind, listPrev(lst, ind));
+    lst->sorted = false;
+    listCompactTouch(lst, ind);
+    listCompactTouch(lst, dst + 1);
+    listBatchUnlink(lst, ind);
+    listBatchLink(lst, ind, dst);
+    return VAR_NOERROR;
+}
+
+template<typename T, typename Policy>
+static void listBatchEnd(ListBatch<T, Policy>* batch){
+    free(batch->log);
+    free(batch->deleted);
+    batch->log     = nullptr;
+    batch->deleted = nullptr;
+    batch->lst     = nullptr;
+}
+
+//! undoes all operations of batch (newest first) and closes it. Capacity stays as it is
+template<typename T, typename Policy>
+varError_t listBatchRollback(ListBatch<T, Policy>* batch){
+    if (batch == nullptr || batch->lst == nullptr){
+        return VAR_BADOP;
+    }
+    List<T, Policy>* lst = batch->lst;
+
+    for (size_t k = batch->log_size; k-- > 0; ){
+        const ListBatchUndo<Policy>* rec = &(batch->log[k]);
+        size_t x = rec->node;
+
+        switch (rec->op){
+            case LIST_BATCH_PUSH:
+            case LIST_BATCH_PUSH_END:
+                listBatchUnlink(lst, x);
+                if (Policy::poison){
+                    listData(lst, x) = ListElemInfo<T>::bad();
+                }
+                if (rec->op == LIST_BATCH_PUSH_END){
+                    listPrev(lst, x) = 0;
+                    listNext(lst, x) = 0;
+                    lst->fmem_end--;
+                }
+                else{
+                    listPrev(lst, x) = x;
+                    listNext(lst, x) = lst->fmem_stack;
+                    lst->fmem_stack  = x;
+                }
+                break;
+            case LIST_BATCH_DELETE:
+                //slot went to top of free stack unless compaction was running
+                if (batch->compact_pos == 0){
+                    lst->fmem_stack = listNext(lst, x);
+                }
+                listData(lst, x) = batch->deleted[--batch->deleted_size];
+                listBatchLink(lst, x, rec->prev);
+                break;
+            case LIST_BATCH_MOVE:
+                listBatchUnlink(lst, x);
+                listBatchLink(lst, x, rec->prev);
+                break;
+            default:
+                break;
+        }
+    }
+
+    lst->sorted      = batch->sorted;
+    lst->compact_pos = batch->compact_pos;
+    listBatchEnd(batch);
+    return listError_dbg(lst);
+}
+
+//! closes batch: list is checked once, put off compaction and shrinking steps are done.
+//! If an operation failed or check finds list broken, batch is rolled back and error is returned
+template<typename T, typename Policy>
+varError_t listBatchCommit(ListBatch<T, Policy>* batch){
+    if (batch == nullptr || batch->lst == nullptr){
+        return VAR_BADOP;
+    }
+    List<T, Policy>* lst = batch->lst;
+
+    varError_t err = batch->err;
+    if (err == VAR_NOERROR){
+        err = listCheck(lst);
+    }
+    if (err != VAR_NOERROR){
+        listBatchRollback(batch);
+        return err;
+    }
+
+    listBatchEnd(batch);
+    listShrinkAuto(lst);
+    listCompactAuto(lst);
+    return VAR_NOERROR;
+}
+
+#endif // LISTBATCH_H_INCLUDED
@@ -0,0 +1,537 @@
+#ifndef LISTCONCURRENT_H_INCLUDED
+#define LISTCONCURRENT_H_INCLUDED
+
+//! Concurrent list access.
+//!
+//! Slot allocation: between listSlotAllocBegin and listSlotAllocEnd free memory of list
+//! is owned by ListSlotAlloc: free stack is a Treiber stack with tagged head (tag is bumped on every
+//! change, so a slot popped and pushed back in between does not fool compare-exchange) and fmem_end
+//! is bumped atomically. Free stack links stay in next array and are accessed atomically.
+//! Any number of threads may take and give back slots at once; capacity is fixed in between,
+//! and other list functions must not be called.
+//!
+//! Concurrent list (ListConcurrent, listConcBegin .. listConcEnd) is built on it. Writers lock only
+//! stripes (slot % LIST_CONC_STRIPES) of nodes they change links of. Readers take no locks: they
+//! follow next links and read elements under per-stripe versions (odd while stripe is written).
+//! Deleted node keeps its next link and its slot is given back only when every reader that could
+//! stand on it has finished (epochs), so traversal never jumps to reused slot.
+//! Indexes given to writers are checked before any lock: sentinel, slots allocator has not handed
+//! out yet and slots marked free are rejected with VAR_BADOP.
+//!
+//! Cost: a single thread pays for all of this (seq_cst epoch per read section, acquire load and
+//! liveness check per step, version check per element, up to 3 stripe locks per write). On the
+//! 90/10 read/write bench with one thread it runs about 4x slower than a plain list behind one
+//! mutex (7-9 vs 28-35 Mops/s, split32, 1M ops), so it only pays off when several cores work
+//! on the list at once; scaling with cores is measured by List_bench (conc/mutex 90/10 Nt).
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <thread>
+
+#include "List.h"
+
+//! slot part of tagged stack head, higher half is tag
+static const uint64_t LIST_SLOT_MASK = 0xffffffffULL;
+
+struct ListSlotAlloc{
+    std::atomic<uint64_t> head; //!< tag << 32 | top slot of free stack
+    std::atomic<size_t>   end;  //!< first never used slot, may run past capacity + 1
+    size_t capacity;
+};
+
+//atomic access to links of free slots
+template<typename I>
+static inline size_t listAtomicLoad(const I* ptr){
+#if defined(__GNUC__)
+    return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+#else
+    return reinterpret_cast<const std::atomic<I>*>(ptr)->load(std::memory_order_relaxed);
+#endif
+}
+template<typename I>
+static inline void listAtomicStore(I* ptr, size_t val){
+#if defined(__GNUC__)
+    __atomic_store_n(ptr, (I)val, __ATOMIC_RELAXED);
+#else
+    reinterpret_cast<std::atomic<I>*>(ptr)->store((I)val, std::memory_order_relaxed);
+#endif
+}
+//! load that sees everything written before listAtomicPublish of same link
+template<typename I>
+static inline size_t listAtomicAcquire(const I* ptr){
+#if defined(__GNUC__)
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#else
+    return reinterpret_cast<const std::atomic<I>*>(ptr)->load(std::memory_order_acquire);
+#endif
+}
+template<typename I>
+static inline void listAtomicPublish(I* ptr, size_t val){
+#if defined(__GNUC__)
+    __atomic_store_n(ptr, (I)val, __ATOMIC_RELEASE);
+#else
+    reinterpret_cast<std::atomic<I>*>(ptr)->store((I)val, std::memory_order_release);
+#endif
+}
+template<typename W>
+static inline bool listAtomicCopyBy(void* dst, const void* src, size_t size){
+    if (((uintptr_t)dst | (uintptr_t)src | size) % sizeof(W) != 0){
+        return false;
+    }
+    for (size_t k = 0; k < size / sizeof(W); k++){
+        std::atomic<W>* d = reinterpret_cast<std::atomic<W>*>((W*)dst + k);
+        const std::atomic<W>* s = reinterpret_cast<const std::atomic<W>*>((const W*)src + k);
+        d->store(s->load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    return true;
+}
+//! element copy made of relaxed atomic loads and stores (of widest words alignment allows),
+//! so it may run together with a writer: result is then thrown away by version check
+static inline void listAtomicCopy(void* dst, const void* src, size_t size){
+    listAtomicCopyBy<uint64_t>(dst, src, size) || listAtomicCopyBy<uint32_t>(dst, src, size) ||
+    listAtomicCopyBy<uint16_t>(dst, src, size) || listAtomicCopyBy<uint8_t >(dst, src, size);
+}
+
+//! hands free memory of list to alloc. Running compaction is finished first (it keeps free slots
+//! off the stack). VAR_BADOP if capacity does not fit in 32-bit slot part of stack head
+template<typename T, typename Policy>
+varError_t listSlotAllocBegin(List<T, Policy>* lst, ListSlotAlloc* alloc){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (alloc == nullptr || lst->capacity >= LIST_SLOT_MASK){
+        return VAR_BADOP;
+    }
+    if (lst->compact_pos != 0){
+        listCompactFinish(lst);
+    }
+    alloc->head.store(lst->fmem_stack, std::memory_order_relaxed);
+    alloc->end.store(lst->fmem_end, std::memory_order_relaxed);
+    alloc->capacity = lst->capacity;
+    std::atomic_thread_fence(std::memory_order_release);
+    return VAR_NOERROR;
+}
+
+//! gives free memory back to list. No thread may use alloc during or after it
+template<typename T, typename Policy>
+varError_t listSlotAllocEnd(List<T, Policy>* lst, ListSlotAlloc* alloc){
+    if (alloc == nullptr){
+        return VAR_BADOP;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    size_t end = alloc->end.load(std::memory_order_relaxed);
+    lst->fmem_stack = alloc->head.load(std::memory_order_relaxed) & LIST_SLOT_MASK;
+    lst->fmem_end   = (end > alloc->capacity + 1) ? alloc->capacity + 1 : end;
+
+    listCheckRet(lst, listError_dbg(lst));
+    return VAR_NOERROR;
+}
+
+//! takes free slot (lock-free), 0 if there is none. Slot is not linked to list
+template<typename T, typename Policy>
+size_t listSlotAcquire(List<T, Policy>* lst, ListSlotAlloc* alloc){
+    uint64_t head = alloc->head.load(std::memory_order_acquire);
+    while ((head & LIST_SLOT_MASK) != 0){
+        size_t slot = head & LIST_SLOT_MASK;
+        //slot may be taken and its link changed meanwhile: tag makes exchange fail then
+        uint64_t next = listAtomicLoad(&listNext(lst, slot));
+        uint64_t new_head = (head & ~LIST_SLOT_MASK) + (LIST_SLOT_MASK + 1) + next;
+        if (alloc->head.compare_exchange_weak(head, new_head, std::memory_order_acquire, std::memory_order_acquire)){
+            return slot;
+        }
+    }
+
+    size_t slot = alloc->end.fetch_add(1, std::memory_order_relaxed);
+    return (slot <= alloc->capacity) ? slot : 0;
+}
+
+//! gives back chain of slots first -> .. -> last (linked by next) with one exchange
+template<typename T, typename Policy>
+void listSlotReleaseChain(List<T, Policy>* lst, ListSlotAlloc* alloc, size_t first, size_t last){
+    //slots are marked free (see List); concurrent list may read links and element of stale index meanwhile
+    T bad = ListElemInfo<T>::bad();
+    for (size_t i = first; ; i = listAtomicLoad(&listNext(lst, i))){
+        listAtomicStore(&listPrev(lst, i), i);
+        if (Policy::poison)
+            listAtomicCopy(&listData(lst, i), &bad, sizeof(T));
+        if (i == last)
+            break;
+    }
+
+    uint64_t head = alloc->head.load(std::memory_order_relaxed);
+    do{
+        listAtomicStore(&listNext(lst, last), head & LIST_SLOT_MASK);
+    } while (!alloc->head.compare_exchange_weak(head, (head & ~LIST_SLOT_MASK) + (LIST_SLOT_MASK + 1) + first,
+                                                std::memory_order_release, std::memory_order_relaxed));
+}
+
+//! gives back slot taken by listSlotAcquire (or unlinked by caller) to free stack (lock-free)
+template<typename T, typename Policy>
+void listSlotRelease(List<T, Policy>* lst, ListSlotAlloc* alloc, size_t slot){
+    listSlotReleaseChain(lst, alloc, slot, slot);
+}
+
+//! lock stripes, power of 2
+static const size_t LIST_CONC_STRIPES = 256;
+//! reader epoch slots, more threads than this can read at once, but wait for free slot
+static const size_t LIST_CONC_READERS = 64;
+//! retired slots are given back to allocator in batches of this size
+static const size_t LIST_CONC_RETIRE_BATCH = 64;
+//! keeps stripes and reader slots on separate cache lines
+static const size_t LIST_CONC_LINE = 64;
+
+struct ListConcStripe{
+    std::mutex lock;
+    std::atomic<uint32_t> version; //!< odd while element of stripe is written
+    char pad[LIST_CONC_LINE];
+};
+
+struct ListConcReader{
+    std::atomic<uint64_t> epoch;   //!< epoch reader started in, 0 if slot is free
+    char pad[LIST_CONC_LINE - sizeof(uint64_t)];
+};
+
+struct ListConcRetired{
+    size_t   slot;
+    uint64_t epoch;
+};
+
+template<typename T, typename Policy = ListDefaultPolicy>
+struct ListConcurrent{
+    List<T, Policy>* lst;
+    ListSlotAlloc alloc;
+    ListConcStripe* stripes;
+    std::atomic<size_t> size;
+    std::atomic<bool>   changed;  //!< list is not sorted after listConcEnd if set
+
+    std::atomic<uint64_t> epoch;
+    ListConcReader readers[LIST_CONC_READERS];
+    std::mutex retire_lock;
+    std::vector<ListConcRetired> retired;
+};
+
+//! puts list to concurrent mode with at least capacity slots (list is resized if needed).
+//! Capacity is fixed until listConcEnd, list itself must not be used in between.
+//! VAR_BADOP if rank or value index is enabled: they can not be kept concurrently
+template<typename T, typename Policy>
+varError_t listConcBegin(ListConcurrent<T, Policy>* clst, List<T, Policy>* lst, size_t capacity = 0){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (clst == nullptr || lst->rank.nodes != nullptr || lst->hash.table != nullptr){
+        return VAR_BADOP;
+    }
+    if (capacity > lst->capacity || !listHasMem(lst)){
+        varError_t err = listResize(lst, (capacity > lst->capacity) ? capacity : lst->growth.min_capacity);
+        if (err != VAR_NOERROR){
+            return err;
+        }
+    }
+    clst->stripes = new (std::nothrow) ListConcStripe[LIST_CONC_STRIPES];
+    if (clst->stripes == nullptr){
+        return VAR_INTERR;
+    }
+    varError_t err = listSlotAllocBegin(lst, &(clst->alloc));
+    if (err != VAR_NOERROR){
+        delete[] clst->stripes;
+        clst->stripes = nullptr;
+        return err;
+    }
+    for (size_t k = 0; k < LIST_CONC_STRIPES; k++){
+        clst->stripes[k].version.store(0, std::memory_order_relaxed);
+    }
+    for (size_t k = 0; k < LIST_CONC_READERS; k++){
+        clst->readers[k].epoch.store(0, std::memory_order_relaxed);
+    }
+    clst->lst = lst;
+    clst->size.store(lst->size, std::memory_order_relaxed);
+    clst->changed.store(false, std::memory_order_relaxed);
+    clst->epoch.store(1, std::memory_order_relaxed);
+    clst->retired.clear();
+    std::atomic_thread_fence(std::memory_order_release);
+    return VAR_NOERROR;
+}
+
+//! gives slots of deleted nodes no reader can stand on back to allocator. Caller holds retire_lock
+template<typename T, typename Policy>
+static void listConcReclaim(ListConcurrent<T, Policy>* clst){
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = UINT64_MAX;
+    for (size_t k = 0; k < LIST_CONC_READERS; k++){
+        uint64_t e = clst->readers[k].epoch.load(std::memory_order_seq_cst);
+        oldest = (e != 0 && e < oldest) ? e : oldest;
+    }
+
+    size_t kept = 0;
+    for (size_t k = 0; k < clst->retired.size(); k++){
+        if (clst->retired[k].epoch < oldest){
+            listSlotRelease(clst->lst, &(clst->alloc), clst->retired[k].slot);
+        }
+        else{
+            clst->retired[kept++] = clst->retired[k];
+        }
+    }
+    clst->retired.resize(kept);
+    //readers starting from now on can not reach slots retired so far
+    clst->epoch.fetch_add(1, std::memory_order_seq_cst);
+}
+
+//! puts list back to normal mode. No thread may use clst during or after it
+template<typename T, typename Policy>
+varError_t listConcEnd(ListConcurrent<T, Policy>* clst){
+    if (clst == nullptr || clst->lst == nullptr){
+        return VAR_BADOP;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    List<T, Policy>* lst = clst->lst;
+    for (size_t k = 0; k < clst->retired.size(); k++){
+        listSlotRelease(lst, &(clst->alloc), clst->retired[k].slot);
+    }
+    clst->retired.clear();
+    lst->size = clst->size.load(std::memory_order_relaxed);
+    if (clst->changed.load(std::memory_order_relaxed)){
+        lst->sorted = false;
+    }
+    delete[] clst->stripes;
+    clst->stripes = nullptr;
+    clst->lst     = nullptr;
+    return listSlotAllocEnd(lst, &(clst->alloc));
+}
+
+static inline size_t listConcStripe(size_t slot){
+    return slot & (LIST_CONC_STRIPES - 1);
+}
+
+//! locks stripes of up to 3 slots in increasing stripe order (no deadlocks), returns their count
+template<typename T, typename Policy>
+static size_t listConcLock(ListConcurrent<T, Policy>* clst, size_t* locked, size_t a, size_t b, size_t c){
+    size_t s[3] = {listConcStripe(a), listConcStripe(b), listConcStripe(c)};
+    std::sort(s, s + 3);
+    size_t n = 0;
+    for (size_t k = 0; k < 3; k++){
+        if (n == 0 || s[k] != locked[n - 1]){
+            locked[n++] = s[k];
+        }
+    }
+    for (size_t k = 0; k < n; k++){
+        clst->stripes[locked[k]].lock.lock();
+    }
+    return n;
+}
+
+template<typename T, typename Policy>
+static void listConcUnlock(ListConcurrent<T, Policy>* clst, const size_t* locked, size_t n){
+    for (size_t k = n; k-- > 0; ){
+        clst->stripes[locked[k]].lock.unlock();
+    }
+}
+
+//! true if slot holds node of list (free and deleted slots have prev == slot)
+template<typename T, typename Policy>
+static inline bool listConcLive(ListConcurrent<T, Policy>* clst, size_t slot){
+    return slot == 0 || listAtomicLoad(&listPrev(clst->lst, slot)) != slot;
+}
+
+//! true if ind is a node slot: not sentinel, handed out by allocator and not marked free.
+//! Checked before any stripe is locked, so stale or garbage indexes take no locks
+template<typename T, typename Policy>
+static inline bool listConcIsNode(ListConcurrent<T, Policy>* clst, size_t ind){
+    size_t end = clst->alloc.end.load(std::memory_order_acquire);
+    if (end > clst->alloc.capacity + 1){
+        end = clst->alloc.capacity + 1;
+    }
+    return ind != 0 && ind < end && listAtomicLoad(&listPrev(clst->lst, ind)) != ind;
+}
+
+//! inserts elem after node ind, returns index of new node (0 on failure).
+//! VAR_BADOP if ind is not in list or list is full
+template<typename T, typename Policy>
+size_t listConcPushAfter(ListConcurrent<T, Policy>* clst, size_t ind, T elem, varError_t* err_ptr = nullptr){
+    List<T, Policy>* lst = clst->lst;
+    if (ind != 0 && !listConcIsNode(clst, ind)){
+        if (err_ptr)
+            *err_ptr = VAR_BADOP;
+        return 0;
+    }
+
+    size_t x = listSlotAcquire(lst, &(clst->alloc));
+    if (x == 0){
+        {
+            std::lock_guard<std::mutex> guard(clst->retire_lock);
+            listConcReclaim(clst);
+        }
+        x = listSlotAcquire(lst, &(clst->alloc));
+    }
+    if (x == 0){
+        if (err_ptr)
+            *err_ptr = VAR_BADOP;
+        return 0;
+    }
+    //x is not reachable by readers until it is published by next link of ind.
+    //Slot from unused end is not marked yet: mark it, so x given to other writers is rejected
+    listAtomicStore(&listPrev(lst, x), x);
+    listAtomicCopy(&listData(lst, x), &elem, sizeof(T));
+
+    while (true){
+        size_t next = listAtomicLoad(&listNext(lst, ind));
+        size_t locked[3] = {};
+        size_t n = listConcLock(clst, locked, ind, next, next);
+        if (!listConcLive(clst, ind)){
+            listConcUnlock(clst, locked, n);
+            listSlotRelease(lst, &(clst->alloc), x);
+            if (err_ptr)
+                *err_ptr = VAR_BADOP;
+            return 0;
+        }
+        if (listAtomicLoad(&listNext(lst, ind)) != next){
+            listConcUnlock(clst, locked, n);
+            continue;
+        }
+
+        listAtomicStore(&listNext(lst, x), next);
+        listAtomicStore(&listPrev(lst, x), ind);
+        listAtomicPublish(&listNext(lst, ind), x);
+        listAtomicStore(&listPrev(lst, next), x);
+        listConcUnlock(clst, locked, n);
+        break;
+    }
+
+    clst->size.fetch_add(1, std::memory_order_relaxed);
+    clst->changed.store(true, std::memory_order_relaxed);
+    if (err_ptr)
+        *err_ptr = VAR_NOERROR;
+    return x;
+}
+
+//! removes node ind from list. Its slot is reused only after readers that could see it finish.
+//! VAR_BADOP if ind is not in list
+template<typename T, typename Policy>
+varError_t listConcDelete(ListConcurrent<T, Policy>* clst, size_t ind){
+    List<T, Policy>* lst = clst->lst;
+    if (!listConcIsNode(clst, ind)){
+        return VAR_BADOP;
+    }
+
+    while (true){
+        size_t prev = listAtomicLoad(&listPrev(lst, ind));
+        size_t next = listAtomicLoad(&listNext(lst, ind));
+        if (prev == ind){
+            return VAR_BADOP;
+        }
+        size_t locked[3] = {};
+        size_t n = listConcLock(clst, locked, prev, ind, next);
+        //prev == ind means node was deleted meanwhile, loop returns then
+        if (listAtomicLoad(&listPrev(lst, ind)) != prev || listAtomicLoad(&listNext(lst, ind)) != next){
+            listConcUnlock(clst, locked, n);
+            continue;
+        }
+
+        //next link of deleted node stays, readers standing on it go on from there
+        listAtomicPublish(&listNext(lst, prev), next);
+        listAtomicStore(&listPrev(lst, next), prev);
+        listAtomicStore(&listPrev(lst, ind), ind);
+        listConcUnlock(clst, locked, n);
+        break;
+    }
+
+    clst->size.fetch_sub(1, std::memory_order_relaxed);
+    clst->changed.store(true, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> guard(clst->retire_lock);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    clst->retired.push_back({ind, clst->epoch.load(std::memory_order_seq_cst)});
+    if (clst->retired.size() >= LIST_CONC_RETIRE_BATCH){
+        listConcReclaim(clst);
+    }
+    return VAR_NOERROR;
+}
+
+//! sets element of node ind. VAR_BADOP if ind is not in list
+template<typename T, typename Policy>
+varError_t listConcSet(ListConcurrent<T, Policy>* clst, size_t ind, T elem){
+    List<T, Policy>* lst = clst->lst;
+    if (!listConcIsNode(clst, ind)){
+        return VAR_BADOP;
+    }
+    ListConcStripe* stripe = &(clst->stripes[listConcStripe(ind)]);
+    std::lock_guard<std::mutex> guard(stripe->lock);
+    if (!listConcLive(clst, ind)){
+        return VAR_BADOP;
+    }
+    uint32_t v = stripe->version.load(std::memory_order_relaxed);
+    stripe->version.store(v + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    listAtomicCopy(&listData(lst, ind), &elem, sizeof(T));
+    stripe->version.store(v + 2, std::memory_order_release);
+    return VAR_NOERROR;
+}
+
+//! starts read section: nodes seen in it are not reused until listConcReadEnd.
+//! Returns reader id to give to listConcReadEnd. Sections should be short: they hold slot reuse
+template<typename T, typename Policy>
+size_t listConcReadBegin(ListConcurrent<T, Policy>* clst){
+    size_t k = std::hash<std::thread::id>()(std::this_thread::get_id()) % LIST_CONC_READERS;
+    while (true){
+        uint64_t free_epoch = 0;
+        uint64_t e = clst->epoch.load(std::memory_order_seq_cst);
+        if (clst->readers[k].epoch.compare_exchange_strong(free_epoch, e, std::memory_order_seq_cst)){
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return k;
+        }
+        k = (k + 1) % LIST_CONC_READERS;
+    }
+}
+
+template<typename T, typename Policy>
+void listConcReadEnd(ListConcurrent<T, Policy>* clst, size_t reader){
+    clst->readers[reader].epoch.store(0, std::memory_order_release);
+}
+
+//! next node in list after ind (0 at the end), call only in read section.
+//! Deleted ind is allowed: nodes after it are given then
+template<typename T, typename Policy>
+size_t listConcNext(ListConcurrent<T, Policy>* clst, size_t ind){
+    size_t i = listAtomicAcquire(&listNext(clst->lst, ind));
+    while (i != 0 && !listConcLive(clst, i)){
+        i = listAtomicAcquire(&listNext(clst->lst, i));
+    }
+    return i;
+}
+
+//! reads element of node ind (lock-free, retried while its stripe is written).
+//! false if ind is not in list. Outside read section ind may be deleted and reused meanwhile
+template<typename T, typename Policy>
+bool listConcGet(ListConcurrent<T, Policy>* clst, size_t ind, T* elem){
+    if (!listConcIsNode(clst, ind)){
+        return false;
+    }
+    ListConcStripe* stripe = &(clst->stripes[listConcStripe(ind)]);
+    while (true){
+        uint32_t v = stripe->version.load(std::memory_order_acquire);
+        if (v & 1){
+            std::this_thread::yield();
+            continue;
+        }
+        bool live = listConcLive(clst, ind);
+        listAtomicCopy(elem, &listData(clst->lst, ind), sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (stripe->version.load(std::memory_order_relaxed) == v){
+            return live;
+        }
+    }
+}
+
+//! calls func(ind, elem) for every node in list order in one read section.
+//! Nodes inserted or deleted meanwhile may be seen or not
+template<typename T, typename Policy, typename Func>
+void listConcForEach(ListConcurrent<T, Policy>* clst, Func func){
+    size_t reader = listConcReadBegin(clst);
+    for (size_t i = listConcNext(clst, 0); i != 0; i = listConcNext(clst, i)){
+        T elem;
+        if (listConcGet(clst, i, &elem)){
+            func(i, elem);
+        }
+    }
+    listConcReadEnd(clst, reader);
+}
+
+#endif // LISTCONCURRENT_H_INCLUDED
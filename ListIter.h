@@ -0,0 +1,162 @@
+#ifndef LISTITER_H_INCLUDED
+#define LISTITER_H_INCLUDED
+
+//! STL-style access to List: bidirectional iterators, begin()/end() for range-for
+//! and <algorithm>, and prefetching forward traversal for fragmented lists.
+//! Iterators are indexes into list storage: any insertion that resizes the list,
+//! compaction step or serialization invalidates them.
+
+#include <iterator>
+#include <type_traits>
+
+#include "List.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define LIST_PREFETCH(_addr) __builtin_prefetch(_addr)
+#elif defined(_MSC_VER)
+    #include <xmmintrin.h>
+    #define LIST_PREFETCH(_addr) _mm_prefetch((const char*)(_addr), _MM_HINT_T0)
+#else
+    #define LIST_PREFETCH(_addr) ((void)(_addr))
+#endif
+
+//! default prefetch distance (nodes ahead) for listPrefetchRange
+static const size_t LIST_PREFETCH_DIST = 8;
+
+template<typename T, typename Policy, bool Const>
+struct ListIterator{
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef T         value_type;
+    typedef ptrdiff_t difference_type;
+    typedef typename std::conditional<Const, const T*, T*>::type pointer;
+    typedef typename std::conditional<Const, const T&, T&>::type reference;
+    typedef typename std::conditional<Const, const List<T, Policy>*, List<T, Policy>*>::type list_ptr;
+
+    list_ptr lst;
+    size_t ind; //!< 0 is end()
+
+    ListIterator(list_ptr lst_ = nullptr, size_t ind_ = 0) : lst(lst_), ind(ind_) {}
+
+    //non-const -> const conversion
+    operator ListIterator<T, Policy, true>() const{
+        return ListIterator<T, Policy, true>(lst, ind);
+    }
+
+    reference operator* () const { return  listData(lst, ind); }
+    pointer   operator->() const { return &listData(lst, ind); }
+
+    ListIterator& operator++(){
+        ind = listNext(lst, ind);
+        return *this;
+    }
+    ListIterator& operator--(){
+        ind = listPrev(lst, ind);
+        return *this;
+    }
+    ListIterator operator++(int){
+        ListIterator t = *this;
+        ++(*this);
+        return t;
+    }
+    ListIterator operator--(int){
+        ListIterator t = *this;
+        --(*this);
+        return t;
+    }
+
+    bool operator==(const ListIterator& other) const { return ind == other.ind; }
+    bool operator!=(const ListIterator& other) const { return ind != other.ind; }
+};
+
+template<typename T, typename Policy>
+ListIterator<T, Policy, false> begin(List<T, Policy>& lst){
+    return ListIterator<T, Policy, false>(&lst, listHasMem(&lst) ? listNext(&lst, 0) : 0);
+}
+template<typename T, typename Policy>
+ListIterator<T, Policy, false> end(List<T, Policy>& lst){
+    return ListIterator<T, Policy, false>(&lst, 0);
+}
+
+template<typename T, typename Policy>
+ListIterator<T, Policy, true> begin(const List<T, Policy>& lst){
+    return ListIterator<T, Policy, true>(&lst, listHasMem(&lst) ? listNext(&lst, 0) : 0);
+}
+template<typename T, typename Policy>
+ListIterator<T, Policy, true> end(const List<T, Policy>& lst){
+    return ListIterator<T, Policy, true>(&lst, 0);
+}
+
+//! forward iterator that keeps a second index dist nodes ahead and prefetches its node
+//! (NODES) or data (SPLIT), so per-element work overlaps with cache misses of the walk.
+//! The walk itself is not shortened: next of next is unknown until next is loaded, so the
+//! ahead walk still takes one miss per node, and a traversal doing little per element
+//! gains nothing. The link of ahead is not prefetched: the walk loads it on the next step
+//! anyway, and the extra prefetch only competed with the data one
+template<typename T, typename Policy, bool Const>
+struct ListPrefetchIterator : ListIterator<T, Policy, Const>{
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ListIterator<T, Policy, Const> base_t;
+
+    size_t ahead;
+
+    ListPrefetchIterator(typename base_t::list_ptr lst_ = nullptr, size_t ind_ = 0, size_t dist = 0) :
+        base_t(lst_, ind_), ahead(ind_)
+    {
+        for (size_t i = 0; i < dist && ahead != 0; i++){
+            ahead = listNext(this->lst, ahead);
+            prefetch();
+        }
+    }
+
+    void prefetch() const{
+        if (Policy::layout == LIST_LAYOUT_NODES){
+            LIST_PREFETCH(this->lst->nodes + ahead);
+        }
+        else{
+            LIST_PREFETCH(this->lst->data + ahead);
+        }
+    }
+
+    ListPrefetchIterator& operator++(){
+        this->ind = listNext(this->lst, this->ind);
+        if (ahead != 0){
+            ahead = listNext(this->lst, ahead);
+            prefetch();
+        }
+        return *this;
+    }
+    ListPrefetchIterator operator++(int){
+        ListPrefetchIterator t = *this;
+        ++(*this);
+        return t;
+    }
+};
+
+template<typename T, typename Policy, bool Const>
+struct ListPrefetchRange{
+    typedef ListPrefetchIterator<T, Policy, Const> iterator;
+
+    typename iterator::list_ptr lst;
+    size_t dist;
+
+    iterator begin() const{
+        return iterator(lst, listHasMem(lst) ? listNext(lst, 0) : 0, dist);
+    }
+    iterator end() const{
+        return iterator(lst, 0, 0);
+    }
+};
+
+//! range for prefetching traversal: for (int& x : listPrefetchRange(&lst, 16)) ...
+template<typename T, typename Policy>
+ListPrefetchRange<T, Policy, false> listPrefetchRange(List<T, Policy>* lst, size_t dist = LIST_PREFETCH_DIST){
+    ListPrefetchRange<T, Policy, false> range = {lst, dist};
+    return range;
+}
+template<typename T, typename Policy>
+ListPrefetchRange<T, Policy, true> listPrefetchRange(const List<T, Policy>* lst, size_t dist = LIST_PREFETCH_DIST){
+    ListPrefetchRange<T, Policy, true> range = {lst, dist};
+    return range;
+}
+
+#endif // LISTITER_H_INCLUDED
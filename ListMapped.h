@@ -0,0 +1,149 @@
+#ifndef LISTMAPPED_H_INCLUDED
+#define LISTMAPPED_H_INCLUDED
+
+//! File-backed list. Links are indexes, so storage arrays can be used right from a mapped
+//! file: opening a cleanly closed file costs O(1) whatever its size. Growth extends the sparse file
+//! in place, data moves only when a region outgrows its span (see List_mapped.cpp).
+//! listDtor syncs and closes the file, elements stay in it.
+//! Rank and value indexes are not stored, they are built when file is opened.
+
+#include "List.h"
+
+//! rebuilds size and free memory of list from its links after file was not closed cleanly.
+//! Free stack gets every slot below last live one which is not in list. O(capacity)
+template<typename T, typename Policy>
+static varError_t listMapRecover(List<T, Policy>* lst){
+    uint8_t* live = (uint8_t*)calloc(lst->capacity + 1, 1);
+    if (live == nullptr){
+        return VAR_INTERR;
+    }
+
+    size_t size = 0;
+    size_t last = 0;
+    bool in_order = true;
+    size_t prev = 0;
+    for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i)){
+        if (i > lst->capacity || live[i] || listPrev(lst, i) != prev){
+            free(live);
+            return VAR_CORRUPT;
+        }
+        live[i] = 1;
+        size++;
+        in_order = in_order && (i == size);
+        last = (i > last) ? i : last;
+        prev = i;
+    }
+    if (listPrev(lst, 0) != prev){
+        free(live);
+        return VAR_CORRUPT;
+    }
+
+    lst->size       = size;
+    lst->fmem_end   = last + 1;
+    lst->fmem_stack = 0;
+    lst->sorted     = in_order;
+    for (size_t i = last; i >= 1; i--){
+        if (!live[i]){
+            listPrev(lst, i) = i;
+            listNext(lst, i) = lst->fmem_stack;
+            lst->fmem_stack = i;
+        }
+    }
+    free(live);
+    return VAR_NOERROR;
+}
+
+//! opens list file at path (created with capacity slots if it does not exist or is empty)
+//! and makes it storage of lst. lst must be constructed and have no storage yet.
+//! VAR_BADOP if file holds list of other element type, index type, layout or protection
+template<typename T, typename Policy>
+varError_t listOpenMapped(List<T, Policy>* lst, const char* path, size_t capacity = 0){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (path == nullptr || listHasMem(lst) || lst->map != nullptr){
+        return VAR_BADOP;
+    }
+    if (capacity < lst->growth.min_capacity){
+        capacity = lst->growth.min_capacity;
+    }
+    if (capacity > listMaxCapacity(lst)){
+        return VAR_BADOP;
+    }
+
+    ListMapLayout layout = listMapLayoutOf(lst);
+    ListMapState state = {capacity, 0, 0, 1, true, 0};
+    void* arrays[LIST_MAP_MAX_ARRAYS] = {};
+    varError_t err = VAR_NOERROR;
+    ListMapping* map = listMapOpen(path, &layout, &state, arrays, &err);
+    if (map == nullptr){
+        return err;
+    }
+    if (state.capacity > listMaxCapacity(lst)){
+        listMapClose(map);
+        return VAR_BADOP;
+    }
+
+    lst->map = map;
+    listMapSetArrays(lst, arrays);
+    lst->capacity   = state.capacity;
+    lst->size       = state.size;
+    lst->fmem_stack = state.fmem_stack;
+    lst->fmem_end   = state.fmem_end;
+    lst->sorted     = state.sorted;
+    lst->compact_pos = 0;
+
+    bool fresh = (state.size == 0 && state.fmem_end == 1);
+    if (fresh && Policy::poison){
+        for (size_t i = 1; i <= lst->capacity; i++){
+            listData(lst, i) = ListElemInfo<T>::bad();
+        }
+    }
+    if (!state.clean){
+        Error_log("%s", "list file was not closed, recovering it from links\n");
+        err = listMapRecover(lst);
+        if (err != VAR_NOERROR){
+            //file is left as it is, list goes back to empty
+            void* no_arrays[LIST_MAP_MAX_ARRAYS] = {};
+            listMapClose(map);
+            listMapSetArrays(lst, no_arrays);
+            lst->map        = nullptr;
+            lst->capacity   = 0;
+            lst->size       = 0;
+            lst->fmem_stack = 0;
+            lst->fmem_end   = 1;
+            lst->sorted     = true;
+            return err;
+        }
+    }
+    listReplaceDataCanary(lst);
+
+    //indexes enabled on empty list are built for new storage
+    if (lst->rank.nodes != nullptr){
+        listRankIndexDisable(lst);
+        listRankIndexEnable(lst);
+    }
+    if (lst->hash.table != nullptr && !listHashBuild(lst)){
+        listHashIndexDisable(lst);
+    }
+
+    //file is marked open until listDtor: crash in between leads to recovery on next open
+    state = listMapStateOf(lst, false);
+    if (!listMapSync(map, &state)){
+        return VAR_INTERR;
+    }
+    return VAR_NOERROR;
+}
+
+//! writes list state to its file and flushes mapped storage to disk
+template<typename T, typename Policy>
+varError_t listSyncMapped(List<T, Policy>* lst){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (lst->map == nullptr){
+        return VAR_BADOP;
+    }
+    ListMapState state = listMapStateOf(lst, false);
+    return listMapSync(lst->map, &state) ? VAR_NOERROR : VAR_INTERR;
+}
+
+#endif // LISTMAPPED_H_INCLUDED
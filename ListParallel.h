@@ -0,0 +1,363 @@
+#ifndef LISTPARALLEL_H_INCLUDED
+#define LISTPARALLEL_H_INCLUDED
+
+//! Multi-threaded list ranking (sublist sampling) and operations built on it.
+//! List is cut by sampled splitter nodes into sublists, which are walked in parallel
+//! to get their lengths, then sublist offsets are summed in list order and the
+//! sublists are walked again, now knowing logical position of every node.
+//! Results are the same as of sequential versions.
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "List.h"
+
+//! lists shorter than this are ranked in one thread
+static const size_t LIST_PARALLEL_MIN_SIZE = 1 << 16;
+//! splitters per thread (more splitters - better balance, more sequential work in between)
+static const size_t LIST_PARALLEL_SPLIT_PER_THREAD = 16;
+
+static inline unsigned listThreadCount(unsigned threads){
+    if (threads == 0){
+        threads = std::thread::hardware_concurrency();
+    }
+    return (threads == 0) ? 1 : threads;
+}
+
+//! runs func(thread_id) in threads threads (thread 0 is the caller)
+template<typename Func>
+static void listParallelRun(unsigned threads, Func func){
+    std::vector<std::thread> pool;
+    unsigned started = 1;
+    try{
+        for (; started < threads; started++){
+            pool.push_back(std::thread(func, started));
+        }
+    }
+    catch (...){
+        Error_log("%s", "can not start thread, running in fewer threads\n");
+    }
+    func(0);
+    //work of threads that did not start
+    for (unsigned t = started; t < threads; t++){
+        func(t);
+    }
+    for (size_t t = 0; t < pool.size(); t++){
+        pool[t].join();
+    }
+}
+
+//! runs func(begin, end) over [0, n) split into equal chunks
+template<typename Func>
+static void listParallelFor(unsigned threads, size_t n, Func func){
+    listParallelRun(threads, [&](unsigned t){
+        func(n * t / threads, n * (t + 1) / threads);
+    });
+}
+
+static inline bool listBitGet(const uint8_t* bits, size_t i){
+    return bits[i >> 3] & (1 << (i & 7));
+}
+static inline void listBitSet(uint8_t* bits, size_t i){
+    bits[i >> 3] |= (uint8_t)(1 << (i & 7));
+}
+
+//! calls func(ind, pos) once for every node, pos is logical position (1..size).
+//! Calls for different nodes run concurrently.
+//! Returns VAR_CORRUPT if links do not form a list of size nodes
+template<typename T, typename Policy, typename Func>
+static varError_t listRankForEach(const List<T, Policy>* lst, unsigned threads, Func func){
+    if (lst->size == 0 || !listHasMem(lst)){
+        return VAR_NOERROR;
+    }
+    threads = listThreadCount(threads);
+    if (lst->size < LIST_PARALLEL_MIN_SIZE){
+        threads = 1;
+    }
+
+    size_t slots = lst->fmem_end;
+    uint8_t* split_bits = (uint8_t*)calloc((slots + 7) / 8, 1);
+    if (split_bits == nullptr){
+        return VAR_INTERR;
+    }
+
+    //splitters: head and live nodes sampled evenly over storage, sorted by slot
+    size_t split_want = (threads == 1) ? 1 : threads * LIST_PARALLEL_SPLIT_PER_THREAD;
+    std::vector<size_t> split;
+    split.push_back(listNext(lst, 0));
+    listBitSet(split_bits, listNext(lst, 0));
+    for (size_t k = 1; k < split_want; k++){
+        size_t from = 1 + (slots - 1) * k / split_want;
+        size_t to   = 1 + (slots - 1) * (k + 1) / split_want;
+        for (size_t i = from; i < to; i++){
+            if (listPrev(lst, i) != i){
+                if (!listBitGet(split_bits, i)){
+                    listBitSet(split_bits, i);
+                    split.push_back(i);
+                }
+                break;
+            }
+        }
+    }
+    std::sort(split.begin(), split.end());
+    size_t split_cnt = split.size();
+
+    std::vector<size_t> len(split_cnt, 0);
+    std::vector<size_t> stop(split_cnt, 0);
+    std::vector<size_t> offset(split_cnt, 0);
+    bool corrupt = false;
+
+    //pass 1: sublist lengths
+    listParallelRun(threads, [&](unsigned t){
+        for (size_t s = t; s < split_cnt; s += threads){
+            size_t i = split[s];
+            size_t n = 0;
+            do{
+                n++;
+                i = listNext(lst, i);
+            } while (i != 0 && i < slots && !listBitGet(split_bits, i) && n <= lst->size);
+            len [s] = n;
+            stop[s] = i;
+        }
+    });
+
+    //sublist offsets in list order
+    size_t pos = 1;
+    size_t visited = 0;
+    size_t cur = listNext(lst, 0);
+    while (cur != 0 && visited < split_cnt){
+        size_t s = std::lower_bound(split.begin(), split.end(), cur) - split.begin();
+        if (s == split_cnt || split[s] != cur){
+            break;
+        }
+        offset[s] = pos;
+        pos += len[s];
+        cur = stop[s];
+        visited++;
+    }
+    if (cur != 0 || visited != split_cnt || pos != lst->size + 1){
+        corrupt = true;
+    }
+
+    //pass 2: positions
+    if (!corrupt){
+        listParallelRun(threads, [&](unsigned t){
+            for (size_t s = t; s < split_cnt; s += threads){
+                size_t i = split[s];
+                for (size_t n = 0; n < len[s]; n++){
+                    func(i, offset[s] + n);
+                    i = listNext(lst, i);
+                }
+            }
+        });
+    }
+
+    free(split_bits);
+    return corrupt ? VAR_CORRUPT : VAR_NOERROR;
+}
+
+//! ranks[i] = logical position of node i (1..size), 0 for free slots.
+//! ranks must have fmem_end elements. threads == 0 - all cores
+template<typename T, typename Policy>
+varError_t listRank(const List<T, Policy>* lst, size_t* ranks, unsigned threads = 0){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (lst->fmem_end > 1){
+        memset(ranks, 0, lst->fmem_end * sizeof(size_t));
+    }
+    return listRankForEach(lst, threads, [&](size_t ind, size_t pos){
+        ranks[ind] = pos;
+    });
+}
+
+//! copies elements to dst (size elements) in list order
+template<typename T, typename Policy>
+varError_t listToArray(const List<T, Policy>* lst, T* dst, unsigned threads = 0){
+    listCheckRet(lst, listError_dbg(lst));
+
+    return listRankForEach(lst, threads, [&](size_t ind, size_t pos){
+        dst[pos - 1] = listData(lst, ind);
+    });
+}
+
+//! links slots 1..size in order and marks the rest of storage free (elements must be in place)
+template<typename T, typename Policy>
+static void listRelinkDense(List<T, Policy>* lst, unsigned threads){
+    size_t size = lst->size;
+    listParallelFor(threads, lst->capacity + 1, [&](size_t from, size_t to){
+        for (size_t i = from; i < to; i++){
+            if (i == 0){
+                listNext(lst, 0) = (size == 0) ? 0 : 1;
+                listPrev(lst, 0) = size;
+            }
+            else if (i <= size){
+                listNext(lst, i) = (i == size) ? 0 : i + 1;
+                listPrev(lst, i) = i - 1;
+            }
+            else if (Policy::poison){
+                listData(lst, i) = ListElemInfo<T>::bad();
+                listNext(lst, i) = 0;
+                listPrev(lst, i) = 0;
+            }
+        }
+    });
+
+    lst->sorted = true;
+    lst->fmem_end = size + 1;
+    lst->fmem_stack = 0;
+    lst->compact_pos = 0;
+}
+
+//! listSerialize by parallel scatter into new element storage.
+//! Needs new element (or node) and link arrays instead of O(1) memory of listSerialize;
+//! all of them are allocated before the list is touched, so on error the list is unchanged
+template<typename T, typename Policy>
+varError_t listSerializeParallel(List<T, Policy>* lst, size_t new_size, unsigned threads = 0){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (new_size < lst->size || new_size > listMaxCapacity(lst)){
+        return VAR_BADOP;
+    }
+    threads = listThreadCount(threads);
+    if (!listHasMem(lst) || threads == 1 || lst->size < LIST_PARALLEL_MIN_SIZE || lst->map != nullptr){
+        return listSerialize(lst, new_size);
+    }
+
+    typedef typename List<T, Policy>::node_t node_t;
+    typedef typename Policy::index_t index_t;
+    bool nodes = (Policy::layout == LIST_LAYOUT_NODES);
+    size_t offset    = listDataBeginOffset(lst);
+    size_t elem_size = nodes ? sizeof(node_t) : sizeof(T);
+    bool   zero      = Policy::check || Policy::poison;
+    void* new_arr  = nullptr;
+    void* new_prev = nullptr;
+    void* new_next = nullptr;
+    auto free_new = [&](){
+        if (new_arr != nullptr)
+            listStorageFree(new_arr , listArrMemSize(lst, elem_size      , new_size), offset);
+        if (new_prev != nullptr)
+            listStorageFree(new_prev, listArrMemSize(lst, sizeof(index_t), new_size), offset);
+        if (new_next != nullptr)
+            listStorageFree(new_next, listArrMemSize(lst, sizeof(index_t), new_size), offset);
+    };
+    if (!listStorageResize(&new_arr, 0, listArrMemSize(lst, elem_size, new_size), offset, zero) ||
+        (!nodes && (!listStorageResize(&new_prev, 0, listArrMemSize(lst, sizeof(index_t), new_size), offset, zero) ||
+                    !listStorageResize(&new_next, 0, listArrMemSize(lst, sizeof(index_t), new_size), offset, zero)))){
+        free_new();
+        return VAR_INTERR;
+    }
+    T*      new_data  = (T*)     new_arr;
+    node_t* new_nodes = (node_t*)new_arr;
+
+    varError_t err = listRankForEach(lst, threads, [&](size_t ind, size_t pos){
+        if (nodes)
+            new_nodes[pos].data = lst->nodes[ind].data;
+        else
+            new_data[pos] = lst->data[ind];
+    });
+    if (err != VAR_NOERROR){
+        free_new();
+        return err;
+    }
+
+    //nothing can fail from here on
+    if (nodes){
+        new_nodes[0] = lst->nodes[0];
+        listStorageFree(lst->nodes, listArrMemSize(lst, elem_size, lst->capacity), offset);
+        lst->nodes = new_nodes;
+    }
+    else{
+        new_data[0] = lst->data[0];
+        listStorageFree(lst->data, listArrMemSize(lst, elem_size      , lst->capacity), offset);
+        listStorageFree(lst->prev, listArrMemSize(lst, sizeof(index_t), lst->capacity), offset);
+        listStorageFree(lst->next, listArrMemSize(lst, sizeof(index_t), lst->capacity), offset);
+        lst->data = new_data;
+        lst->prev = (index_t*)new_prev;
+        lst->next = (index_t*)new_next;
+    }
+    size_t old_capacity = lst->capacity;
+    lst->capacity = new_size;
+
+    listRelinkDense(lst, threads);
+    if (lst->rank.nodes != nullptr){
+        if (listRankMemResize(lst, old_capacity, new_size)){
+            listRankBuild(lst);
+        }
+        else{
+            listRankIndexDisable(lst);
+        }
+    }
+    if (lst->hash.table != nullptr && !listHashBuild(lst)){
+        listHashIndexDisable(lst);
+    }
+
+    listReplaceDataCanary(lst);
+    return VAR_NOERROR;
+}
+
+//! stable sort by value (see listSort). Large lists are extracted to an array, sorted in
+//! threads chunks which are then merged pairwise, and scattered back as a serialized list.
+//! Needs two element arrays of size elements. Small lists go to listSort
+template<typename T, typename Policy, typename Cmp = std::less<T>>
+varError_t listSortParallel(List<T, Policy>* lst, Cmp cmp = Cmp(), unsigned threads = 0){
+    listCheckRet(lst, listError_dbg(lst));
+
+    threads = listThreadCount(threads);
+    if (!listHasMem(lst) || threads == 1 || lst->size < LIST_PARALLEL_MIN_SIZE){
+        return listSort(lst, cmp);
+    }
+
+    size_t n = lst->size;
+    T* buf = (T*)calloc(2 * n, sizeof(T));
+    if (buf == nullptr){
+        return VAR_INTERR;
+    }
+    T* a = buf;
+    T* b = buf + n;
+
+    varError_t err = listToArray(lst, a, threads);
+    if (err != VAR_NOERROR){
+        free(buf);
+        return err;
+    }
+
+    std::vector<size_t> bound(threads + 1);
+    for (unsigned t = 0; t <= threads; t++){
+        bound[t] = n * t / threads;
+    }
+    listParallelRun(threads, [&](unsigned t){
+        std::stable_sort(a + bound[t], a + bound[t + 1], cmp);
+    });
+    //runs of width chunks are merged into runs of 2*width, merge takes left run first on equal elements
+    for (size_t width = 1; width < threads; width *= 2){
+        listParallelRun(threads, [&](unsigned t){
+            size_t l = t * 2 * width;
+            if (l >= threads){
+                return;
+            }
+            size_t m = std::min<size_t>(l + width,     threads);
+            size_t r = std::min<size_t>(l + 2 * width, threads);
+            std::merge(a + bound[l], a + bound[m], a + bound[m], a + bound[r], b + bound[l], cmp);
+        });
+        std::swap(a, b);
+    }
+
+    listParallelFor(threads, n, [&](size_t from, size_t to){
+        for (size_t i = from; i < to; i++){
+            listData(lst, i + 1) = a[i];
+        }
+    });
+    free(buf);
+
+    listRelinkDense(lst, threads);
+    if (lst->rank.nodes != nullptr){
+        listRankBuild(lst);
+    }
+    if (lst->hash.table != nullptr && !listHashBuild(lst)){
+        listHashIndexDisable(lst);
+    }
+    return VAR_NOERROR;
+}
+
+#endif // LISTPARALLEL_H_INCLUDED
@@ -0,0 +1,310 @@
+#ifndef LISTPOOL_H_INCLUDED
+#define LISTPOOL_H_INCLUDED
+
+//! Shared node pool for many small lists.
+//! Pool is a List used only as slot storage: its data/next/prev arrays and free list
+//! are shared by all PoolList heads. Every PoolList owns one sentinel slot in the pool
+//! and is a ring through it, so nodes move between lists of one pool by relinking only.
+
+#include "List.h"
+
+template<typename T, typename Policy = ListDefaultPolicy>
+struct ListPool{
+    List<T, Policy> mem; //!< mem.size is number of used slots (including sentinels)
+};
+
+template<typename T, typename Policy = ListDefaultPolicy>
+struct PoolList{
+    ListPool<T, Policy>* pool;
+    size_t head; //!< sentinel slot in pool
+    size_t size;
+};
+
+#ifdef listPoolCtor
+    #error redefinition of internal macro listPoolCtor
+#endif
+#define listPoolCtor(_pool)  \
+    if (listCtor_(&((_pool)->mem))){  \
+        listSetInfo(&((_pool)->mem), varInfoInit(_pool)); \
+        (_pool)->mem.sorted = false;  \
+        (_pool)->mem.pool   = true;   \
+    }                       \
+    else {                  \
+        Error_log("%s", "bad ptr passed to constructor\n");\
+    }
+
+template<typename T, typename Policy>
+varError_t listPoolError(const ListPool<T, Policy>* pool){
+    if (pool == nullptr)
+        return VAR_NULL;
+    return listError(&(pool->mem));
+}
+
+template<typename T, typename Policy>
+void listPoolDump(const ListPool<T, Policy>* pool){
+    printf_log("List pool (%lu slots used)\n", pool->mem.size);
+    listDump(&(pool->mem), false);
+}
+
+template<typename T, typename Policy>
+varError_t listPoolDtor(ListPool<T, Policy>* pool){
+    return listDtor(&(pool->mem));
+}
+
+//! reserves slots for at least capacity nodes (including list sentinels)
+template<typename T, typename Policy>
+varError_t listPoolReserve(ListPool<T, Policy>* pool, size_t capacity){
+    if (capacity <= pool->mem.capacity)
+        return VAR_NOERROR;
+    return listResize(&(pool->mem), capacity);
+}
+
+template<typename T, typename Policy>
+static size_t listPoolAlloc(ListPool<T, Policy>* pool, varError_t* err_ptr){
+    List<T, Policy>* mem = &(pool->mem);
+    size_t ni = listGetFreeMem(mem);
+
+    if (ni == 0){
+        if (mem->capacity >= listMaxCapacity(mem)){
+            if (err_ptr)
+                *err_ptr = VAR_BADOP;
+            return 0;
+        }
+        varError_t err = listResize_(mem, listGrowCapacity(mem, mem->capacity + 1));
+        if (err != VAR_NOERROR){
+            if (err_ptr)
+                *err_ptr = err;
+            return 0;
+        }
+        ni = listGetFreeMem(mem);
+    }
+    mem->size++;
+    return ni;
+}
+
+template<typename T, typename Policy>
+static void listPoolFree(ListPool<T, Policy>* pool, size_t ind){
+    List<T, Policy>* mem = &(pool->mem);
+    if (Policy::poison){
+        listData(mem, ind) = ListElemInfo<T>::bad();
+    }
+    listAddFreeMem(mem, ind);
+    mem->size--;
+}
+
+//! true if ind is an element or the sentinel of lst.
+//! Protected pools verify ownership by walking from ind to the sentinel (O(size));
+//! otherwise ind must belong to lst and only liveness of the slot is checked (O(1))
+template<typename T, typename Policy>
+static bool poolListIsNode(const PoolList<T, Policy>* lst, size_t ind){
+    const List<T, Policy>* mem = &(lst->pool->mem);
+    if (ind == lst->head){
+        return true;
+    }
+    if (ind == 0 || ind >= mem->fmem_end || listPrev(mem, ind) == ind){
+        return false;
+    }
+    if (Policy::check){
+        for (size_t steps = 0; steps < lst->size; steps++){
+            ind = listNext(mem, ind);
+            if (ind == lst->head)
+                return true;
+        }
+        return false;
+    }
+    return true;
+}
+
+template<typename T, typename Policy>
+varError_t poolListCtor(PoolList<T, Policy>* lst, ListPool<T, Policy>* pool){
+    listCheckRet(&(pool->mem), listError_dbg(&(pool->mem)));
+
+    varError_t err = VAR_NOERROR;
+    size_t head = listPoolAlloc(pool, &err);
+    if (head == 0){
+        return err;
+    }
+
+    listNext(&(pool->mem), head) = head;
+    listPrev(&(pool->mem), head) = head;
+
+    lst->pool = pool;
+    lst->head = head;
+    lst->size = 0;
+    return VAR_NOERROR;
+}
+
+//! returns all nodes of list (and its sentinel) to pool in O(size): freed slots are marked (see List)
+template<typename T, typename Policy>
+varError_t poolListDtor(PoolList<T, Policy>* lst){
+    ListPool<T, Policy>* pool = lst->pool;
+    List<T, Policy>* mem = &(pool->mem);
+    listCheckRet(mem, listError_dbg(mem));
+
+    if (lst->head == 0){
+        return VAR_DEAD;
+    }
+
+    size_t tail = listPrev(mem, lst->head);
+
+    size_t i = listNext(mem, lst->head);
+    while (i != lst->head){
+        size_t t = listNext(mem, i);
+        if (Policy::poison){
+            listData(mem, i) = ListElemInfo<T>::bad();
+        }
+        listPrev(mem, i) = i;
+        i = t;
+    }
+    listPrev(mem, lst->head) = lst->head;
+
+    //chain head->...->tail is already linked by next, push it to free stack at once
+    listNext(mem, tail) = mem->fmem_stack;
+    mem->fmem_stack = lst->head;
+    mem->size -= lst->size + 1;
+
+    lst->head = 0;
+    lst->size = 0;
+    lst->pool = nullptr;
+    return VAR_NOERROR;
+}
+
+//! first element of list, 0 if list is empty
+template<typename T, typename Policy>
+inline size_t poolListFirst(const PoolList<T, Policy>* lst){
+    size_t i = listNext(&(lst->pool->mem), lst->head);
+    return (i == lst->head) ? 0 : i;
+}
+
+//! last element of list, 0 if list is empty
+template<typename T, typename Policy>
+inline size_t poolListLast(const PoolList<T, Policy>* lst){
+    size_t i = listPrev(&(lst->pool->mem), lst->head);
+    return (i == lst->head) ? 0 : i;
+}
+
+//! element after ind, 0 at the end
+template<typename T, typename Policy>
+inline size_t poolListNext(const PoolList<T, Policy>* lst, size_t ind){
+    size_t i = listNext(&(lst->pool->mem), ind);
+    return (i == lst->head) ? 0 : i;
+}
+
+template<typename T, typename Policy>
+inline T& poolListData(PoolList<T, Policy>* lst, size_t ind){
+    return listData(&(lst->pool->mem), ind);
+}
+
+//! inserts elem after ind (ind == 0 inserts at front). Returns index of new node (0 on error)
+template<typename T, typename Policy>
+size_t poolListPushAfter(PoolList<T, Policy>* lst, size_t ind, T elem, varError_t* err_ptr){
+    ListPool<T, Policy>* pool = lst->pool;
+    List<T, Policy>* mem = &(pool->mem);
+    listCheckRetPtr(mem, err_ptr, 0);
+
+    if (ind == 0){
+        ind = lst->head;
+    }
+    if (!poolListIsNode(lst, ind)){
+        if (err_ptr)
+            *err_ptr = VAR_BADOP;
+        return 0;
+    }
+
+    size_t ni = listPoolAlloc(pool, err_ptr);
+    if (ni == 0){
+        return 0;
+    }
+
+    listData(mem, ni) = elem;
+    listPrev(mem, ni) = ind;
+    listNext(mem, ni) = listNext(mem, ind);
+    listPrev(mem, listNext(mem, ind)) = ni;
+    listNext(mem, ind) = ni;
+
+    lst->size++;
+    return ni;
+}
+
+template<typename T, typename Policy>
+size_t poolListPushBack(PoolList<T, Policy>* lst, T elem, varError_t* err_ptr){
+    return poolListPushAfter(lst, listPrev(&(lst->pool->mem), lst->head), elem, err_ptr);
+}
+
+template<typename T, typename Policy>
+varError_t poolListDeleteElem(PoolList<T, Policy>* lst, size_t ind){
+    ListPool<T, Policy>* pool = lst->pool;
+    List<T, Policy>* mem = &(pool->mem);
+    listCheckRet(mem, listError_dbg(mem));
+
+    if (ind == lst->head || !poolListIsNode(lst, ind)){
+        return VAR_BADOP;
+    }
+
+    listNext(mem, listPrev(mem, ind)) = listNext(mem, ind);
+    listPrev(mem, listNext(mem, ind)) = listPrev(mem, ind);
+    listPoolFree(pool, ind);
+
+    lst->size--;
+    return VAR_NOERROR;
+}
+
+//! moves nodes first..last of src to position after dst_pos in dst (dst_pos == 0 is front).
+//! Lists must share one pool. Relinks in O(1); count is number of moved nodes,
+//! pass 0 to have it counted. Protected pools always verify the range
+template<typename T, typename Policy>
+varError_t poolListSplice(PoolList<T, Policy>* dst, size_t dst_pos,
+                          PoolList<T, Policy>* src, size_t first, size_t last, size_t count = 0){
+    List<T, Policy>* mem = &(src->pool->mem);
+    listCheckRet(mem, listError_dbg(mem));
+
+    if (dst->pool != src->pool){
+        return VAR_BADOP;
+    }
+    if (dst_pos == 0){
+        dst_pos = dst->head;
+    }
+    if (first == src->head || last == src->head ||
+        !poolListIsNode(src, first) || !poolListIsNode(src, last) || !poolListIsNode(dst, dst_pos)){
+        return VAR_BADOP;
+    }
+
+    if (Policy::check || count == 0){
+        size_t len = 1;
+        for (size_t i = first; i != last; i = listNext(mem, i)){
+            if (i == src->head || len > src->size)
+                return VAR_BADOP;
+            if (i == dst_pos && dst == src)
+                return VAR_BADOP;
+            len++;
+        }
+        if (last == dst_pos && dst == src){
+            return VAR_BADOP;
+        }
+        if (count != 0 && count != len){
+            return VAR_BADOP;
+        }
+        count = len;
+    }
+
+    size_t before = listPrev(mem, first);
+    if (before == dst_pos){
+        return VAR_NOERROR;
+    }
+
+    size_t after = listNext(mem, last);
+    listNext(mem, before) = after;
+    listPrev(mem, after ) = before;
+
+    size_t dst_next = listNext(mem, dst_pos);
+    listNext(mem, dst_pos ) = first;
+    listPrev(mem, first   ) = dst_pos;
+    listNext(mem, last    ) = dst_next;
+    listPrev(mem, dst_next) = last;
+
+    src->size -= count;
+    dst->size += count;
+    return VAR_NOERROR;
+}
+
+#endif // LISTPOOL_H_INCLUDED
@@ -0,0 +1,190 @@
+#ifndef LISTQUEUE_H_INCLUDED
+#define LISTQUEUE_H_INCLUDED
+
+//! FIFO queue mode of list (listQueueBegin .. listQueueEnd): push goes after the last node,
+//! pop takes the first one. Only data and next arrays are used; prev links and size are
+//! rebuilt by listQueueEnd. Head is a dummy node: slot of last popped element (sentinel at first),
+//! so producers and consumer never write same link.
+//!
+//! LIST_QUEUE_SPSC: one producer and one consumer thread, wait-free. Popped slots stay linked
+//! from old heads to current head and producer takes them back from there, no atomic RMW at all.
+//! LIST_QUEUE_MPSC: any number of producers and one consumer. Producer takes slot from
+//! ListSlotAlloc and exchanges tail; consumer gives back all slots of a batch with one exchange.
+//! Producer preempted between tail exchange and linking hides elements after it until it links.
+//!
+//! Capacity is fixed in queue mode, push fails when it is full. No memory is allocated after begin.
+
+#include "ListConcurrent.h"
+
+enum ListQueueMode{
+    LIST_QUEUE_SPSC,
+    LIST_QUEUE_MPSC,
+};
+
+template<typename T, typename Policy = ListDefaultPolicy>
+struct ListQueue{
+    List<T, Policy>* lst;
+    ListQueueMode mode;
+    ListSlotAlloc alloc;
+
+    //consumer side
+    std::atomic<size_t> head;      //!< dummy node, element after it is popped next
+    char pad_head[LIST_CONC_LINE];
+
+    //producer side
+    std::atomic<size_t> tail;
+    size_t first;                  //!< SPSC: oldest popped slot, first..head are free to reuse
+    size_t head_copy;              //!< SPSC: head seen by producer last time
+    char pad_tail[LIST_CONC_LINE];
+};
+
+//! puts list to queue mode, elements already in list are queued in list order.
+//! List gets at least capacity slots. VAR_BADOP if rank or value index is enabled
+template<typename T, typename Policy>
+varError_t listQueueBegin(ListQueue<T, Policy>* queue, List<T, Policy>* lst, ListQueueMode mode, size_t capacity = 0){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (queue == nullptr || lst->rank.nodes != nullptr || lst->hash.table != nullptr){
+        return VAR_BADOP;
+    }
+    if (capacity > lst->capacity || !listHasMem(lst)){
+        varError_t err = listResize(lst, (capacity > lst->capacity) ? capacity : lst->growth.min_capacity);
+        if (err != VAR_NOERROR){
+            return err;
+        }
+    }
+    varError_t err = listSlotAllocBegin(lst, &(queue->alloc));
+    if (err != VAR_NOERROR){
+        return err;
+    }
+    queue->lst       = lst;
+    queue->mode      = mode;
+    queue->first     = 0;
+    queue->head_copy = 0;
+    queue->head.store(0, std::memory_order_relaxed);
+    queue->tail.store(listPrev(lst, 0), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return VAR_NOERROR;
+}
+
+//! puts list back to normal mode with queued elements in it. No thread may use queue during or after it
+template<typename T, typename Policy>
+varError_t listQueueEnd(ListQueue<T, Policy>* queue){
+    if (queue == nullptr || queue->lst == nullptr){
+        return VAR_BADOP;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    List<T, Policy>* lst = queue->lst;
+    size_t head = queue->head.load(std::memory_order_relaxed);
+
+    //slots popped but not reused yet (SPSC), sentinel among them is skipped
+    for (size_t i = queue->first; queue->mode == LIST_QUEUE_SPSC && i != head; ){
+        size_t next = listNext(lst, i);
+        if (i != 0)
+            listSlotRelease(lst, &(queue->alloc), i);
+        i = next;
+    }
+    if (head != 0){
+        listNext(lst, 0) = listNext(lst, head);
+        listSlotRelease(lst, &(queue->alloc), head);
+    }
+
+    size_t size = 0;
+    size_t prev = 0;
+    bool in_order = true;
+    for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i)){
+        listPrev(lst, i) = prev;
+        prev = i;
+        size++;
+        in_order = in_order && (i == size);
+    }
+    listPrev(lst, 0) = prev;
+    lst->size   = size;
+    lst->sorted = in_order;
+    queue->lst  = nullptr;
+    return listSlotAllocEnd(lst, &(queue->alloc));
+}
+
+//! SPSC producer: slot popped earlier if consumer is past it, else free slot of list
+template<typename T, typename Policy>
+static size_t listQueueSlotSpsc(ListQueue<T, Policy>* queue){
+    while (true){
+        if (queue->first == queue->head_copy){
+            queue->head_copy = queue->head.load(std::memory_order_acquire);
+            if (queue->first == queue->head_copy)
+                break;
+        }
+        size_t slot = queue->first;
+        queue->first = listAtomicLoad(&listNext(queue->lst, slot));
+        //sentinel is only dummy at start, it is never queued
+        if (slot != 0)
+            return slot;
+    }
+    return listSlotAcquire(queue->lst, &(queue->alloc));
+}
+
+//! adds elem to the end of queue, false if list is full
+template<typename T, typename Policy>
+bool listQueuePush(ListQueue<T, Policy>* queue, T elem){
+    List<T, Policy>* lst = queue->lst;
+    size_t x = (queue->mode == LIST_QUEUE_SPSC) ? listQueueSlotSpsc(queue)
+                                                : listSlotAcquire(lst, &(queue->alloc));
+    if (x == 0){
+        return false;
+    }
+    listAtomicCopy(&listData(lst, x), &elem, sizeof(T));
+    listAtomicStore(&listNext(lst, x), 0);
+
+    size_t prev = 0;
+    if (queue->mode == LIST_QUEUE_SPSC){
+        prev = queue->tail.load(std::memory_order_relaxed);
+        queue->tail.store(x, std::memory_order_relaxed);
+    }
+    else{
+        prev = queue->tail.exchange(x, std::memory_order_acq_rel);
+    }
+    listAtomicPublish(&listNext(lst, prev), x);
+    return true;
+}
+
+//! takes up to max_count elements from the front of queue to elems, returns their count.
+//! Consumer thread only
+template<typename T, typename Policy>
+size_t listQueuePopBatch(ListQueue<T, Policy>* queue, T* elems, size_t max_count){
+    List<T, Policy>* lst = queue->lst;
+    size_t old_head = queue->head.load(std::memory_order_relaxed);
+    size_t head = old_head;
+    size_t last_freed = 0;
+    size_t count = 0;
+
+    for (; count < max_count; count++){
+        size_t next = listAtomicAcquire(&listNext(lst, head));
+        if (next == 0)
+            break;
+        listAtomicCopy(elems + count, &listData(lst, next), sizeof(T));
+        last_freed = head;
+        head = next;
+    }
+    if (count == 0){
+        return 0;
+    }
+    queue->head.store(head, std::memory_order_release);
+
+    //MPSC: popped slots old_head .. last_freed are still linked, they go back at once
+    if (queue->mode == LIST_QUEUE_MPSC){
+        size_t first_freed = (old_head == 0) ? listAtomicLoad(&listNext(lst, 0)) : old_head;
+        if (old_head == 0 && last_freed == 0){
+            return count;
+        }
+        listSlotReleaseChain(lst, &(queue->alloc), first_freed, last_freed);
+    }
+    return count;
+}
+
+//! takes element from the front of queue, false if it is empty. Consumer thread only
+template<typename T, typename Policy>
+bool listQueuePop(ListQueue<T, Policy>* queue, T* elem){
+    return listQueuePopBatch(queue, elem, 1) == 1;
+}
+
+#endif // LISTQUEUE_H_INCLUDED
@@ -0,0 +1,233 @@
+#ifndef LISTSIMD_H_INCLUDED
+#define LISTSIMD_H_INCLUDED
+
+//! Bulk kernels over list elements. When list is sorted and uses LIST_LAYOUT_SPLIT,
+//! data[1..size] is a dense array and kernels run over it: vectorized (SSE2/AVX2,
+//! chosen at runtime, see List_simd.cpp) for int, float and double, plain loops
+//! for other types. Unsorted lists are walked by links.
+//! Float sums are added in vector lanes, so rounding may differ from sequential sum.
+
+#include "List.h"
+
+//scalar versions, also used for element types without vector kernels
+template<typename T>
+T listScalarSum(const T* a, size_t n){
+    T s = 0;
+    for (size_t i = 0; i < n; i++)
+        s += a[i];
+    return s;
+}
+template<typename T>
+T listScalarMin(const T* a, size_t n){
+    T m = a[0];
+    for (size_t i = 1; i < n; i++)
+        m = (a[i] < m) ? a[i] : m;
+    return m;
+}
+template<typename T>
+T listScalarMax(const T* a, size_t n){
+    T m = a[0];
+    for (size_t i = 1; i < n; i++)
+        m = (a[i] > m) ? a[i] : m;
+    return m;
+}
+template<typename T>
+size_t listScalarFind(const T* a, size_t n, T x){
+    for (size_t i = 0; i < n; i++){
+        if (a[i] == x)
+            return i;
+    }
+    return n;
+}
+template<typename T>
+size_t listScalarCount(const T* a, size_t n, T x){
+    size_t c = 0;
+    for (size_t i = 0; i < n; i++)
+        c += (a[i] == x);
+    return c;
+}
+template<typename T>
+void listScalarFill(T* a, size_t n, T x){
+    for (size_t i = 0; i < n; i++)
+        a[i] = x;
+}
+
+template<typename T> T      listSimdSum  (const T* a, size_t n)      { return listScalarSum  (a, n); }
+template<typename T> T      listSimdMin  (const T* a, size_t n)      { return listScalarMin  (a, n); }
+template<typename T> T      listSimdMax  (const T* a, size_t n)      { return listScalarMax  (a, n); }
+template<typename T> size_t listSimdFind (const T* a, size_t n, T x) { return listScalarFind (a, n, x); }
+template<typename T> size_t listSimdCount(const T* a, size_t n, T x) { return listScalarCount(a, n, x); }
+template<typename T> void   listSimdFill (T* a, size_t n, T x)       {        listScalarFill (a, n, x); }
+
+//vector kernels (List_simd.cpp). min/max need n > 0, find returns n if not found
+#define LIST_SIMD_DECL(_type)                                      \
+    _type  listSimdSum  (const _type* a, size_t n);                \
+    _type  listSimdMin  (const _type* a, size_t n);                \
+    _type  listSimdMax  (const _type* a, size_t n);                \
+    size_t listSimdFind (const _type* a, size_t n, _type x);       \
+    size_t listSimdCount(const _type* a, size_t n, _type x);       \
+    void   listSimdFill (_type* a, size_t n, _type x);
+
+LIST_SIMD_DECL(int   )
+LIST_SIMD_DECL(float )
+LIST_SIMD_DECL(double)
+
+#undef LIST_SIMD_DECL
+
+//! true if elements are one dense array data[1..size]
+template<typename T, typename Policy>
+inline bool listIsDense(const List<T, Policy>* lst){
+    return lst->sorted && Policy::layout == LIST_LAYOUT_SPLIT && listHasMem(lst);
+}
+
+template<typename T, typename Policy>
+T listSum(const List<T, Policy>* lst, varError_t* err_ptr = nullptr){
+    listCheckRetPtr(lst, err_ptr, T());
+
+    if (listIsDense(lst)){
+        return listSimdSum(lst->data + 1, lst->size);
+    }
+    T s = 0;
+    if (listHasMem(lst)){
+        for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i))
+            s += listData(lst, i);
+    }
+    return s;
+}
+
+//! smallest element, VAR_BADOP for empty list
+template<typename T, typename Policy>
+T listMin(const List<T, Policy>* lst, varError_t* err_ptr = nullptr){
+    listCheckRetPtr(lst, err_ptr, ListElemInfo<T>::bad());
+
+    if (lst->size == 0){
+        if (err_ptr)
+            *err_ptr = VAR_BADOP;
+        return ListElemInfo<T>::bad();
+    }
+    if (listIsDense(lst)){
+        return listSimdMin(lst->data + 1, lst->size);
+    }
+    size_t i = listNext(lst, 0);
+    T m = listData(lst, i);
+    for (i = listNext(lst, i); i != 0; i = listNext(lst, i))
+        m = (listData(lst, i) < m) ? listData(lst, i) : m;
+    return m;
+}
+
+//! largest element, VAR_BADOP for empty list
+template<typename T, typename Policy>
+T listMax(const List<T, Policy>* lst, varError_t* err_ptr = nullptr){
+    listCheckRetPtr(lst, err_ptr, ListElemInfo<T>::bad());
+
+    if (lst->size == 0){
+        if (err_ptr)
+            *err_ptr = VAR_BADOP;
+        return ListElemInfo<T>::bad();
+    }
+    if (listIsDense(lst)){
+        return listSimdMax(lst->data + 1, lst->size);
+    }
+    size_t i = listNext(lst, 0);
+    T m = listData(lst, i);
+    for (i = listNext(lst, i); i != 0; i = listNext(lst, i))
+        m = (listData(lst, i) > m) ? listData(lst, i) : m;
+    return m;
+}
+
+//! index of first node equal to elem, 0 if there is none.
+//! With value index (listHashIndexEnable) - O(1), but not necessarily the first node
+template<typename T, typename Policy>
+size_t listFind(const List<T, Policy>* lst, T elem){
+    listCheckRet(lst, 0);
+
+    if (lst->hash.table != nullptr){
+        return listHashFind(lst, elem);
+    }
+    if (listIsDense(lst)){
+        size_t pos = listSimdFind(lst->data + 1, lst->size, elem);
+        return (pos == lst->size) ? 0 : pos + 1;
+    }
+    if (listHasMem(lst)){
+        for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i)){
+            if (listData(lst, i) == elem)
+                return i;
+        }
+    }
+    return 0;
+}
+
+//! number of elements equal to elem
+template<typename T, typename Policy>
+size_t listCount(const List<T, Policy>* lst, T elem){
+    listCheckRet(lst, 0);
+
+    if (listIsDense(lst)){
+        return listSimdCount(lst->data + 1, lst->size, elem);
+    }
+    size_t c = 0;
+    if (listHasMem(lst)){
+        for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i))
+            c += (listData(lst, i) == elem);
+    }
+    return c;
+}
+
+//! number of elements with pred(elem) == true. Dense lists run a plain loop the compiler can vectorize
+template<typename T, typename Policy, typename Pred>
+size_t listCountIf(const List<T, Policy>* lst, Pred pred){
+    listCheckRet(lst, 0);
+
+    size_t c = 0;
+    if (listIsDense(lst)){
+        const T* a = lst->data + 1;
+        for (size_t i = 0; i < lst->size; i++)
+            c += pred(a[i]) ? 1 : 0;
+        return c;
+    }
+    if (listHasMem(lst)){
+        for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i))
+            c += pred(listData(lst, i)) ? 1 : 0;
+    }
+    return c;
+}
+
+//! sets every element to elem
+template<typename T, typename Policy>
+varError_t listFill(List<T, Policy>* lst, T elem){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (listIsDense(lst)){
+        listSimdFill(lst->data + 1, lst->size, elem);
+    }
+    else if (listHasMem(lst)){
+        for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i))
+            listData(lst, i) = elem;
+    }
+    if (lst->hash.table != nullptr){
+        return listHashIndexEnable(lst);
+    }
+    return VAR_NOERROR;
+}
+
+//! elem = func(elem) for every element. Dense lists run a plain loop the compiler can vectorize
+template<typename T, typename Policy, typename Func>
+varError_t listTransform(List<T, Policy>* lst, Func func){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (listIsDense(lst)){
+        T* a = lst->data + 1;
+        for (size_t i = 0; i < lst->size; i++)
+            a[i] = func(a[i]);
+    }
+    else if (listHasMem(lst)){
+        for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i))
+            listData(lst, i) = func(listData(lst, i));
+    }
+    if (lst->hash.table != nullptr){
+        return listHashIndexEnable(lst);
+    }
+    return VAR_NOERROR;
+}
+
+#endif // LISTSIMD_H_INCLUDED
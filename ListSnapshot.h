@@ -0,0 +1,182 @@
+#ifndef LISTSNAPSHOT_H_INCLUDED
+#define LISTSNAPSHOT_H_INCLUDED
+
+//! Binary snapshot of list: header followed by elements in logical order, written as raw bytes
+//! (so T must be trivially copyable, and files are only readable on machines with same byte order).
+//! Loading streams elements in chunks of LIST_SNAPSHOT_CHUNK straight to slots 1..size,
+//! so loaded list is sorted and has no free slots in the middle.
+
+#include "List.h"
+#include "lib/file_read.h"
+
+static const char     LIST_SNAPSHOT_MAGIC[8] = "LISTSNP";
+static const uint32_t LIST_SNAPSHOT_VERSION  = 1;
+static const uint64_t LIST_SNAPSHOT_SEED     = 0xcbf29ce484222325ULL;
+//! elements per read/write; chunk byte size is a multiple of 8, as listChecksum needs
+static const size_t   LIST_SNAPSHOT_CHUNK    = 4096;
+
+struct ListSnapshotHeader{
+    char     magic[8];
+    uint32_t version;
+    uint32_t elem_size;
+    uint64_t count;
+    uint64_t checksum; //!< listChecksum of payload
+};
+
+//! writes count elements from a to file, adds them to checksum
+template<typename T>
+static bool listSnapshotWrite(FILE* file, const T* a, size_t count, uint64_t* checksum){
+    *checksum = listChecksum(*checksum, a, count * sizeof(T));
+    return fwrite(a, sizeof(T), count, file) == count;
+}
+
+//! writes list elements to file at path (file is overwritten)
+template<typename T, typename Policy>
+varError_t listSaveSnapshot(const List<T, Policy>* lst, const char* path){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (path == nullptr){
+        return VAR_BADOP;
+    }
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr){
+        perror_log("can not open snapshot file");
+        return VAR_INTERR;
+    }
+
+    ListSnapshotHeader header = {};
+    memcpy(header.magic, LIST_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version   = LIST_SNAPSHOT_VERSION;
+    header.elem_size = sizeof(T);
+    header.count     = lst->size;
+    header.checksum  = LIST_SNAPSHOT_SEED;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    if (ok && lst->size > 0){
+        if (lst->sorted && Policy::layout == LIST_LAYOUT_SPLIT){
+            //dense list is written right from data array
+            for (size_t pos = 0; ok && pos < lst->size; pos += LIST_SNAPSHOT_CHUNK){
+                size_t n = (lst->size - pos < LIST_SNAPSHOT_CHUNK) ? lst->size - pos : LIST_SNAPSHOT_CHUNK;
+                ok = listSnapshotWrite(file, lst->data + 1 + pos, n, &header.checksum);
+            }
+        }
+        else{
+            T* buf = (T*)calloc(LIST_SNAPSHOT_CHUNK, sizeof(T));
+            ok = (buf != nullptr);
+            size_t n = 0;
+            for (size_t i = listNext(lst, 0); ok && i != 0; i = listNext(lst, i)){
+                buf[n++] = listData(lst, i);
+                if (n == LIST_SNAPSHOT_CHUNK){
+                    ok = listSnapshotWrite(file, buf, n, &header.checksum);
+                    n = 0;
+                }
+            }
+            if (ok && n > 0){
+                ok = listSnapshotWrite(file, buf, n, &header.checksum);
+            }
+            free(buf);
+        }
+    }
+
+    //header is written again with checksum of payload
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok){
+        perror_log("can not write snapshot file");
+        return VAR_INTERR;
+    }
+    return VAR_NOERROR;
+}
+
+//! replaces list content with elements from snapshot file at path. List is resized once if
+//! it has less than count slots. VAR_BADOP if file is not a snapshot of list with same element size,
+//! VAR_CORRUPT if checksum does not match (list is left empty then)
+template<typename T, typename Policy>
+varError_t listLoadSnapshot(List<T, Policy>* lst, const char* path){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (path == nullptr){
+        return VAR_BADOP;
+    }
+    size_t file_size = 0;
+    FILE* file = openBinFile(path, &file_size);
+    if (file == nullptr){
+        return VAR_INTERR;
+    }
+
+    ListSnapshotHeader header = {};
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, LIST_SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version   == LIST_SNAPSHOT_VERSION &&
+              header.elem_size == sizeof(T) &&
+              header.count     <= listMaxCapacity(lst) &&
+              file_size >= sizeof(header) &&
+              //division: count * sizeof(T) of crafted header can overflow
+              header.count == (file_size - sizeof(header)) / sizeof(T) &&
+              (file_size - sizeof(header)) % sizeof(T) == 0;
+    if (!ok){
+        Error_log("%s", "file is not a list snapshot or has other element type\n");
+        fclose(file);
+        return VAR_BADOP;
+    }
+
+    size_t count = header.count;
+    listClear(lst);
+    if (count > lst->capacity || !listHasMem(lst)){
+        size_t new_cap = (count < lst->growth.min_capacity) ? lst->growth.min_capacity : count;
+        varError_t err = listResize_(lst, new_cap);
+        if (err != VAR_NOERROR){
+            fclose(file);
+            return err;
+        }
+    }
+
+    uint64_t checksum = LIST_SNAPSHOT_SEED;
+    if (Policy::layout == LIST_LAYOUT_SPLIT){
+        for (size_t pos = 0; ok && pos < count; pos += LIST_SNAPSHOT_CHUNK){
+            size_t n = (count - pos < LIST_SNAPSHOT_CHUNK) ? count - pos : LIST_SNAPSHOT_CHUNK;
+            ok = fread(lst->data + 1 + pos, sizeof(T), n, file) == n;
+            checksum = listChecksum(checksum, lst->data + 1 + pos, n * sizeof(T));
+        }
+    }
+    else{
+        T* buf = (T*)calloc(LIST_SNAPSHOT_CHUNK, sizeof(T));
+        ok = (buf != nullptr);
+        for (size_t pos = 0; ok && pos < count; pos += LIST_SNAPSHOT_CHUNK){
+            size_t n = (count - pos < LIST_SNAPSHOT_CHUNK) ? count - pos : LIST_SNAPSHOT_CHUNK;
+            ok = fread(buf, sizeof(T), n, file) == n;
+            checksum = listChecksum(checksum, buf, n * sizeof(T));
+            for (size_t k = 0; ok && k < n; k++){
+                listData(lst, pos + k + 1) = buf[k];
+            }
+        }
+        free(buf);
+    }
+    fclose(file);
+
+    if (!ok || checksum != header.checksum){
+        Error_log("%s", "snapshot file is damaged\n");
+        listClear(lst);
+        return ok ? VAR_CORRUPT : VAR_INTERR;
+    }
+
+    for (size_t i = 1; i <= count; i++){
+        listPrev(lst, i  ) = i-1;
+        listNext(lst, i-1) = i;
+    }
+    listNext(lst, count) = 0;
+    listPrev(lst, 0    ) = count;
+
+    lst->size     = count;
+    lst->fmem_end = count + 1;
+
+    if (lst->rank.nodes != nullptr){
+        listRankBuild(lst);
+    }
+    if (lst->hash.table != nullptr && !listHashBuild(lst)){
+        listHashIndexDisable(lst);
+    }
+    return VAR_NOERROR;
+}
+
+#endif // LISTSNAPSHOT_H_INCLUDED
@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+
+#include "List.h"
+#include "ListIter.h"
+#include "ListSimd.h"
+#include "ListParallel.h"
+#include "ListConcurrent.h"
+#include "ListQueue.h"
+#include "ListBatch.h"
+
+typedef ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_SPLIT> SplitPolicy;
+typedef ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> NodesPolicy;
+typedef ListWithIndex<SplitPolicy, uint32_t> Split32Policy;
+typedef ListWithIndex<NodesPolicy, uint32_t> Nodes32Policy;
+
+static const size_t BENCH_DEFAULT_COUNT = 1 << 20;
+static const int    BENCH_TRAVERSE_REPEAT = 10;
+//! rounds of dependent arithmetic per element in "work" traversals (a few hundred cycles)
+static const int    BENCH_ELEM_WORK = 64;
+
+static double secondsSince(clock_t start){
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void printResult(const char* layout_name, const char* test_name, size_t ops, double seconds){
+    printf("%-8s %-18s %10lu ops %8.3f s %10.2f Mops/s\n",
+           layout_name, test_name, ops, seconds, seconds > 0 ? ops / seconds / 1e6 : 0.0);
+}
+
+//! per-element work that depends on the element only (not on links)
+static inline long long benchElemWork(long long x, int work){
+    unsigned long long h = (unsigned long long)x;
+    for (int k = 0; k < work; k++){
+        h = h * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return (work == 0) ? x : (long long)(h >> 33);
+}
+
+template<typename T, typename Policy>
+static long long benchTraverse(const List<T, Policy>* lst, const char* layout_name, const char* test_name, int work = 0){
+    long long sum = 0;
+    clock_t start = clock();
+    for (int r = 0; r < BENCH_TRAVERSE_REPEAT; r++){
+        for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i)){
+            sum += benchElemWork(listData(lst, i), work);
+        }
+    }
+    printResult(layout_name, test_name, lst->size * BENCH_TRAVERSE_REPEAT, secondsSince(start));
+    return sum;
+}
+
+template<typename T, typename Policy>
+static long long benchTraversePrefetch(const List<T, Policy>* lst, const char* layout_name, const char* test_name, int work = 0){
+    long long sum = 0;
+    clock_t start = clock();
+    for (int r = 0; r < BENCH_TRAVERSE_REPEAT; r++){
+        for (const T& elem : listPrefetchRange(lst)){
+            sum += benchElemWork(elem, work);
+        }
+    }
+    printResult(layout_name, test_name, lst->size * BENCH_TRAVERSE_REPEAT, secondsSince(start));
+    return sum;
+}
+
+template<typename T, typename Policy>
+static long long benchSum(const List<T, Policy>* lst, const char* layout_name, const char* test_name){
+    long long sum = 0;
+    clock_t start = clock();
+    for (int r = 0; r < BENCH_TRAVERSE_REPEAT; r++){
+        sum += listSum(lst);
+    }
+    printResult(layout_name, test_name, lst->size * BENCH_TRAVERSE_REPEAT, secondsSince(start));
+    return sum;
+}
+
+template<typename Policy>
+static long long benchLayout(const char* layout_name, size_t count){
+    long long checksum = 0;
+    List<int, Policy> lst;
+    listCtor(&lst);
+
+    //sequential (tail) inserts: list stays in physical order
+    clock_t start = clock();
+    size_t tail = 0;
+    for (size_t i = 0; i < count; i++){
+        tail = listPushAfter(&lst, tail, (int)i, nullptr);
+    }
+    printResult(layout_name, "insert tail", count, secondsSince(start));
+    checksum += benchTraverse(&lst, layout_name, "traverse seq");
+    checksum += benchSum(&lst, layout_name, "listSum seq");
+    listDtor(&lst);
+
+    //random position inserts: physical order is shuffled
+    listCtor(&lst);
+    size_t* inserted = (size_t*)calloc(count + 1, sizeof(size_t));
+    if (inserted == nullptr){
+        perror("can not allocate benchmark memory");
+        return 0;
+    }
+    srand(1);
+    start = clock();
+    for (size_t i = 0; i < count; i++){
+        size_t after = (i == 0) ? 0 : inserted[(size_t)rand() % i];
+        inserted[i] = listPushAfter(&lst, after, (int)i, nullptr);
+    }
+    printResult(layout_name, "insert random", count, secondsSince(start));
+    checksum += benchTraverse(&lst, layout_name, "traverse random");
+    checksum += benchTraversePrefetch(&lst, layout_name, "traverse prefetch");
+    checksum += benchTraverse        (&lst, layout_name, "traverse work"   , BENCH_ELEM_WORK);
+    checksum += benchTraversePrefetch(&lst, layout_name, "prefetch work"   , BENCH_ELEM_WORK);
+
+    //link-level merge sort of the shuffled list, then serialize
+    start = clock();
+    listSort(&lst, std::greater<int>());
+    printResult(layout_name, "sort random", count, secondsSince(start));
+    checksum += listData(&lst, listNext(&lst, 0));
+
+    free(inserted);
+    listDtor(&lst);
+    return checksum;
+}
+
+//! threads take and give back slots (ring of SLOT_BENCH_HELD slots per thread), wall time
+template<typename Policy>
+static void benchSlotAlloc(const char* layout_name, size_t count){
+    static const size_t SLOT_BENCH_HELD = 64;
+    unsigned max_threads = listThreadCount(0);
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2){
+        List<int, Policy> lst;
+        listCtor(&lst);
+        listResize(&lst, SLOT_BENCH_HELD * threads);
+        ListSlotAlloc alloc;
+        listSlotAllocBegin(&lst, &alloc);
+
+        auto start = std::chrono::steady_clock::now();
+        listParallelRun(threads, [&](unsigned){
+            size_t held[SLOT_BENCH_HELD] = {};
+            for (size_t i = 0; i < count / threads; i++){
+                size_t& slot = held[i % SLOT_BENCH_HELD];
+                if (slot != 0){
+                    listSlotRelease(&lst, &alloc, slot);
+                }
+                slot = listSlotAcquire(&lst, &alloc);
+            }
+            for (size_t k = 0; k < SLOT_BENCH_HELD; k++){
+                if (held[k] != 0)
+                    listSlotRelease(&lst, &alloc, held[k]);
+            }
+        });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        char test_name[32] = "";
+        sprintf(test_name, "slot alloc %ut", threads);
+        printResult(layout_name, test_name, count / threads * threads, seconds);
+        listSlotAllocEnd(&lst, &alloc);
+        listDtor(&lst);
+    }
+}
+
+static const size_t CONC_BENCH_SIZE = 1 << 12;
+static const size_t CONC_BENCH_READ_LEN = 16;
+static const unsigned CONC_BENCH_WRITE_PERCENT = 10;
+
+//! 90/10 read/write mix. Read walks CONC_BENCH_READ_LEN nodes from random one, write inserts
+//! a node after random one or deletes node inserted by same thread.
+//! Concurrent list is compared with plain list behind one mutex, wall time. Returns sum of read elements
+template<typename Policy>
+static long long benchConcMix(const char* layout_name, size_t count){
+    unsigned max_threads = listThreadCount(0);
+    std::atomic<long long> checksum(0);
+
+    for (int locked = 1; locked >= 0; locked--){
+        for (unsigned threads = 1; threads <= max_threads; threads *= 2){
+            List<int, Policy> lst;
+            listCtor(&lst);
+            for (size_t i = 0; i < CONC_BENCH_SIZE; i++){
+                listPushAfter(&lst, 0, (int)i, nullptr);
+            }
+            ListConcurrent<int, Policy> clst;
+            std::mutex lock;
+            if (!locked){
+                listConcBegin(&clst, &lst, 2 * CONC_BENCH_SIZE + count);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            listParallelRun(threads, [&](unsigned t){
+                std::vector<size_t> mine;
+                unsigned seed = t * 7919 + 1;
+                long long sum = 0;
+                for (size_t op = 0; op < count / threads; op++){
+                    seed = seed * 1103515245 + 12345;
+                    size_t from = 1 + (seed >> 8) % CONC_BENCH_SIZE;
+                    bool write = (seed >> 4) % 100 < CONC_BENCH_WRITE_PERCENT;
+                    bool insert = mine.empty() || (seed & 1);
+
+                    if (locked){
+                        std::lock_guard<std::mutex> guard(lock);
+                        if (!write){
+                            for (size_t k = 0, i = from; k < CONC_BENCH_READ_LEN && i != 0; k++, i = listNext(&lst, i))
+                                sum += listData(&lst, i);
+                        }
+                        else if (insert){
+                            mine.push_back(listPushAfter(&lst, from, (int)op, nullptr));
+                        }
+                        else{
+                            listDeleteElem(&lst, mine.back());
+                            mine.pop_back();
+                        }
+                        continue;
+                    }
+                    if (!write){
+                        size_t reader = listConcReadBegin(&clst);
+                        for (size_t k = 0, i = from; k < CONC_BENCH_READ_LEN && i != 0; k++, i = listConcNext(&clst, i)){
+                            int elem = 0;
+                            listConcGet(&clst, i, &elem);
+                            sum += elem;
+                        }
+                        listConcReadEnd(&clst, reader);
+                    }
+                    else if (insert){
+                        mine.push_back(listConcPushAfter(&clst, from, (int)op));
+                    }
+                    else{
+                        listConcDelete(&clst, mine.back());
+                        mine.pop_back();
+                    }
+                }
+                checksum.fetch_add(sum, std::memory_order_relaxed);
+            });
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (!locked){
+                listConcEnd(&clst);
+            }
+            char test_name[32] = "";
+            sprintf(test_name, "%s 90/10 %ut", locked ? "mutex" : "conc", threads);
+            printResult(layout_name, test_name, count / threads * threads, seconds);
+            listDtor(&lst);
+        }
+    }
+    return checksum.load();
+}
+
+static const size_t QUEUE_BENCH_CAPACITY = 1 << 12;
+static const size_t QUEUE_BENCH_BATCH = 32;
+
+//! producers (1 for SPSC, threads - 1 for MPSC) push count elements, consumer pops them in batches.
+//! Consumer checks that it got every pushed element, and in SPSC mode that order is kept
+template<typename Policy>
+static void benchQueue(const char* layout_name, size_t count, ListQueueMode mode){
+    unsigned max_threads = listThreadCount(0);
+    unsigned max_producers = (mode == LIST_QUEUE_SPSC) ? 1 : ((max_threads > 2) ? max_threads - 1 : 2);
+
+    for (unsigned producers = 1; producers <= max_producers; producers *= 2){
+        List<int, Policy> lst;
+        listCtor(&lst);
+        ListQueue<int, Policy> queue;
+        listQueueBegin(&queue, &lst, mode, QUEUE_BENCH_CAPACITY);
+        size_t per_producer = count / producers;
+        long long sum = 0;
+        bool in_order = true;
+
+        auto start = std::chrono::steady_clock::now();
+        listParallelRun(producers + 1, [&](unsigned t){
+            if (t == 0){
+                int elems[QUEUE_BENCH_BATCH] = {};
+                for (size_t got = 0; got < per_producer * producers; ){
+                    size_t n = listQueuePopBatch(&queue, elems, QUEUE_BENCH_BATCH);
+                    for (size_t k = 0; k < n; k++){
+                        sum += elems[k];
+                        in_order = in_order && (mode != LIST_QUEUE_SPSC || elems[k] == (int)(got + k));
+                    }
+                    if (n == 0)
+                        std::this_thread::yield();
+                    got += n;
+                }
+                return;
+            }
+            for (size_t i = 0; i < per_producer; i++){
+                while (!listQueuePush(&queue, (int)i))
+                    std::this_thread::yield();
+            }
+        });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        char test_name[32] = "";
+        sprintf(test_name, "queue %s %up", (mode == LIST_QUEUE_SPSC) ? "spsc" : "mpsc", producers);
+        printResult(layout_name, test_name, per_producer * producers, seconds);
+        long long expected = (long long)producers * (long long)(per_producer * (per_producer - 1) / 2);
+        if (sum != expected || !in_order){
+            printf("         queue lost, duplicated or reordered elements (sum %lld, expected %lld)\n", sum, expected);
+        }
+        listQueueEnd(&queue);
+        listDtor(&lst);
+    }
+}
+
+static const size_t BATCH_BENCH_SIZE = 256;
+
+//! checked (protected) list: every listPushAfter runs full list check, batch runs it twice per batch
+static void benchBatch(size_t count){
+    typedef ListProtectPolicy Policy;
+    List<int, Policy> lst;
+    listCtor(&lst);
+    clock_t start = clock();
+    size_t tail = 0;
+    for (size_t i = 0; i < count; i++){
+        tail = listPushAfter(&lst, tail, (int)i, nullptr);
+    }
+    printResult("protect", "insert tail", count, secondsSince(start));
+    listDtor(&lst);
+
+    listCtor(&lst);
+    start = clock();
+    tail = 0;
+    for (size_t i = 0; i < count; ){
+        ListBatch<int, Policy> batch;
+        if (listBatchBegin(&lst, &batch, BATCH_BENCH_SIZE) != VAR_NOERROR){
+            printf("%s", "         batch can not begin\n");
+            break;
+        }
+        for (size_t k = 0; k < BATCH_BENCH_SIZE && i < count; k++, i++){
+            tail = listBatchPushAfter(&batch, tail, (int)i);
+        }
+        listBatchCommit(&batch);
+    }
+    printResult("protect", "insert tail batch", count, secondsSince(start));
+    listDtor(&lst);
+}
+
+static const size_t CHECK_BENCH_SIZE = 1 << 10;
+//! paranoid tier walks whole list on every operation, so it runs fewer of them
+static const size_t CHECK_BENCH_PARANOID_DIV = 64;
+
+//! push + delete on protected list of CHECK_BENCH_SIZE elements with given check tier.
+//! Check time is measured by the list itself in a separate run: clock reads cost as much as cheap checks
+static void benchCheckTier(const char* test_name, size_t count, ListCheckTier tier, size_t every){
+    List<int, ListProtectPolicy> lst;
+    listCtor(&lst);
+    for (size_t i = 0; i < CHECK_BENCH_SIZE; i++){
+        listPushAfter(&lst, 0, (int)i, nullptr);
+    }
+    listSetCheckTier(&lst, tier, every);
+
+    for (int timed = 0; timed < 2; timed++){
+        listSetCheckTiming(&lst, timed);
+        listResetCheckStats(&lst);
+        clock_t start = clock();
+        for (size_t i = 0; i < count; i++){
+            listPushAfter(&lst, 0, (int)i, nullptr);
+            listDeleteElem(&lst, listPrev(&lst, 0));
+        }
+        double seconds = secondsSince(start);
+        if (!timed){
+            printResult("protect", test_name, 2 * count, seconds);
+        }
+    }
+
+    ListCheckStats stats = listCheckStats(&lst);
+    printf("         checks: cheap %llu (%.1f ns) full %llu (%.1f ns) paranoid %llu (%.1f ns)\n",
+           (unsigned long long)stats.cheap_count, stats.cheap_count ? (double)stats.cheap_ns / stats.cheap_count : 0.0,
+           (unsigned long long)stats.full_count , stats.full_count  ? (double)stats.full_ns  / stats.full_count  : 0.0,
+           (unsigned long long)stats.deep_count , stats.deep_count  ? (double)stats.deep_ns  / stats.deep_count  : 0.0);
+    listDtor(&lst);
+}
+
+int main(int argc, const char* argv[]){
+    size_t count = BENCH_DEFAULT_COUNT;
+    if (argc > 1){
+        count = strtoul(argv[1], nullptr, 10);
+    }
+
+    printf("List layout benchmark, %lu elements\n", count);
+    long long checksum = 0;
+    checksum += benchLayout<SplitPolicy>("split", count);
+    checksum += benchLayout<NodesPolicy>("nodes", count);
+    checksum += benchLayout<Split32Policy>("split32", count);
+    checksum += benchLayout<Nodes32Policy>("nodes32", count);
+    benchBatch(count);
+    benchCheckTier("check off"     , count, LIST_CHECK_OFF, 1);
+    benchCheckTier("check cheap"   , count, LIST_CHECK_CHEAP, 1);
+    benchCheckTier("check 1/64"    , count, LIST_CHECK_SAMPLED, 64);
+    benchCheckTier("check full"    , count, LIST_CHECK_SAMPLED, 1);
+    benchCheckTier("check paranoid", count / CHECK_BENCH_PARANOID_DIV, LIST_CHECK_PARANOID, 1);
+    benchSlotAlloc<Split32Policy>("split32", count);
+    checksum += benchConcMix<Split32Policy>("split32", count);
+    benchQueue<Split32Policy>("split32", count, LIST_QUEUE_SPSC);
+    benchQueue<Split32Policy>("split32", count, LIST_QUEUE_MPSC);
+    printf("checksum %lld\n", checksum);
+    return 0;
+}
@@ -0,0 +1,1918 @@
+#ifndef LIST_IMPL_H_INCLUDED
+#define LIST_IMPL_H_INCLUDED
+
+//! template part of List.h, do not include directly
+
+#include "lib/System_utils.h"
+
+#define LIST_DESTRUCT_PTR ((void*)0xBAD)
+
+#define listCheckRet(__lst, ...)  \
+    if(listCheck(__lst)){             \
+        Error_log("%s", "List error");\
+        listDump(__lst);              \
+        return __VA_ARGS__;            \
+    }
+
+#define listCheckRetPtr(__lst, __errptr, ...)  \
+    if(varError_t __check_err = listCheck(__lst)){ \
+        Error_log("%s", "List error");   \
+        listDump(__lst);                 \
+        if(__errptr)                      \
+            *__errptr = __check_err;      \
+        return __VA_ARGS__;               \
+    }
+
+template<typename T, typename Policy>
+constexpr bool listProtected(const List<T, Policy>*){
+    return Policy::check;
+}
+
+template<typename T, typename Policy>
+constexpr size_t listDataBeginOffset(const List<T, Policy>*){
+    return Policy::canary ?   sizeof(canary_t) : 0;
+}
+
+template<typename T, typename Policy>
+constexpr size_t listDataSizeOffset(const List<T, Policy>*){
+    return Policy::canary ? 2*sizeof(canary_t) : 0;
+}
+
+template<typename T, typename Policy>
+inline static void* listDataMemBegin(const List<T, Policy>* lst, const void* arr){
+    assert_log(lst != nullptr);
+    return ((uint8_t*)arr) - listDataBeginOffset(lst);
+}
+
+template<typename T, typename Policy>
+inline static size_t listArrMemSize(const List<T, Policy>* lst, size_t elem_size, size_t capacity){
+    assert_log(lst != nullptr);
+    return ((capacity + 1)*elem_size) + listDataSizeOffset(lst);
+}
+
+//! (re)allocates one storage array of elem_size slots from lst->capacity to new_capacity slots.
+//! Unprotected lists get new slots not zeroed: slots from fmem_end on are never read
+template<typename T, typename Policy>
+static bool listArrResize(List<T, Policy>* lst, void** arr, size_t elem_size, size_t new_capacity){
+    size_t old_size = (*arr == nullptr) ? 0 : listArrMemSize(lst, elem_size, lst->capacity);
+    return listStorageResize(arr, old_size, listArrMemSize(lst, elem_size, new_capacity),
+                             listDataBeginOffset(lst), Policy::check || Policy::poison);
+}
+
+//! storage arrays description for file-backed lists
+template<typename T, typename Policy>
+static ListMapLayout listMapLayoutOf(const List<T, Policy>* lst){
+    ListMapLayout layout = {};
+    layout.layout = Policy::layout;
+    layout.offset = listDataBeginOffset(lst);
+    if (Policy::layout == LIST_LAYOUT_NODES){
+        //element and index sizes are kept to tell types with same node size apart
+        layout.arrays = 1;
+        layout.elem_size[0] = sizeof(typename List<T, Policy>::node_t);
+        layout.elem_size[1] = sizeof(T);
+        layout.elem_size[2] = sizeof(typename Policy::index_t);
+    }
+    else{
+        layout.arrays = 3;
+        layout.elem_size[0] = sizeof(T);
+        layout.elem_size[1] = sizeof(typename Policy::index_t);
+        layout.elem_size[2] = sizeof(typename Policy::index_t);
+    }
+    return layout;
+}
+
+template<typename T, typename Policy>
+static ListMapState listMapStateOf(const List<T, Policy>* lst, bool clean){
+    ListMapState state = {lst->capacity, lst->size, lst->fmem_stack, lst->fmem_end, lst->sorted, clean};
+    return state;
+}
+
+template<typename T, typename Policy>
+static void listMapSetArrays(List<T, Policy>* lst, void** arrays){
+    if (Policy::layout == LIST_LAYOUT_NODES){
+        lst->nodes = (typename List<T, Policy>::node_t*)arrays[0];
+        return;
+    }
+    lst->data = (T*)                          arrays[0];
+    lst->next = (typename Policy::index_t*)arrays[1];
+    lst->prev = (typename Policy::index_t*)arrays[2];
+}
+
+//! (re)allocates storage arrays for new_capacity slots. Does not change lst->capacity.
+template<typename T, typename Policy>
+static bool listMemResize(List<T, Policy>* lst, size_t new_capacity){
+    if (lst->map != nullptr){
+        ListMapLayout layout = listMapLayoutOf(lst);
+        void* arrays[LIST_MAP_MAX_ARRAYS] = {};
+        if (!listMapResize(lst->map, &layout, lst->capacity, new_capacity, arrays)){
+            return false;
+        }
+        listMapSetArrays(lst, arrays);
+        return true;
+    }
+    if (Policy::layout == LIST_LAYOUT_NODES){
+        return listArrResize(lst, (void**)&(lst->nodes), sizeof(typename List<T, Policy>::node_t), new_capacity);
+    }
+    return listArrResize(lst, (void**)&(lst->data), sizeof(T)                          , new_capacity) &&
+           listArrResize(lst, (void**)&(lst->prev), sizeof(typename Policy::index_t), new_capacity) &&
+           listArrResize(lst, (void**)&(lst->next), sizeof(typename Policy::index_t), new_capacity);
+}
+
+template<typename T, typename Policy>
+static void listMemFree(List<T, Policy>* lst){
+    if (lst->map != nullptr){
+        ListMapState state = listMapStateOf(lst, true);
+        listMapSync(lst->map, &state);
+        listMapClose(lst->map);
+        lst->map = nullptr;
+        lst->nodes = nullptr;
+        lst->data  = nullptr;
+        lst->prev  = nullptr;
+        lst->next  = nullptr;
+        return;
+    }
+    size_t offset = listDataBeginOffset(lst);
+    if (lst->nodes != nullptr)
+        listStorageFree(lst->nodes, listArrMemSize(lst, sizeof(typename List<T, Policy>::node_t), lst->capacity), offset);
+    if (lst->data != nullptr)
+        listStorageFree(lst->data, listArrMemSize(lst, sizeof(T), lst->capacity), offset);
+    if (lst->prev != nullptr)
+        listStorageFree(lst->prev, listArrMemSize(lst, sizeof(typename Policy::index_t), lst->capacity), offset);
+    if (lst->next != nullptr)
+        listStorageFree(lst->next, listArrMemSize(lst, sizeof(typename Policy::index_t), lst->capacity), offset);
+    lst->nodes = nullptr;
+    lst->data  = nullptr;
+    lst->prev  = nullptr;
+    lst->next  = nullptr;
+}
+
+template<typename T, typename Policy>
+static void listReplaceDataCanary(List<T, Policy>* lst){
+    if (!Policy::canary)
+        return;
+    if (Policy::layout == LIST_LAYOUT_NODES){
+        *((canary_t*)(lst->nodes + lst->capacity + 1)) = CANARY_R;
+        ((canary_t*)lst->nodes)[-1] = CANARY_L;
+        return;
+    }
+    *((canary_t*)(lst->data + lst->capacity + 1)) = CANARY_R;
+    *((canary_t*)(lst->prev + lst->capacity + 1)) = CANARY_R;
+    *((canary_t*)(lst->next + lst->capacity + 1)) = CANARY_R;
+
+    ((canary_t*)lst->data)[-1] = CANARY_L;
+    ((canary_t*)lst->prev)[-1] = CANARY_L;
+    ((canary_t*)lst->next)[-1] = CANARY_L;
+}
+
+//! (re)allocates order-statistic index for new_capacity slots, new slots are not in tree
+template<typename T, typename Policy>
+static bool listRankMemResize(List<T, Policy>* lst, size_t old_capacity, size_t new_capacity){
+    if (!listAllocOrResize((void**)&(lst->rank.nodes), (new_capacity + 1) * sizeof(ListRankNode), 0)){
+        return false;
+    }
+    if (new_capacity > old_capacity){
+        memset(lst->rank.nodes + old_capacity + 1, 0, (new_capacity - old_capacity) * sizeof(ListRankNode));
+    }
+    return true;
+}
+
+//! rebuilds order-statistic index from list order in O(size)
+template<typename T, typename Policy>
+static void listRankBuild(List<T, Policy>* lst){
+    memset(lst->rank.nodes, 0, (lst->capacity + 1) * sizeof(ListRankNode));
+    lst->rank.root = 0;
+    if (!listHasMem(lst)){
+        return;
+    }
+
+    size_t rightmost = 0;
+    for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i)){
+        listRankBuildAppend(&(lst->rank), i, &rightmost);
+    }
+    listRankBuildEnd(&(lst->rank), rightmost);
+}
+
+//! cell of value index holding elem, or empty cell where it would be
+template<typename T, typename Policy>
+static size_t listHashCell(const List<T, Policy>* lst, const T& elem){
+    size_t mask = lst->hash.table_size - 1;
+    size_t c = ListElemHash<T>::hash(elem) & mask;
+    while (lst->hash.table[c] != 0 && !(listData(lst, lst->hash.table[c]) == elem)){
+        c = (c + 1) & mask;
+    }
+    return c;
+}
+
+//! adds node ind (its data must be set) to value index
+template<typename T, typename Policy>
+static void listHashInsert(List<T, Policy>* lst, size_t ind){
+    size_t* chain = lst->hash.chain;
+    size_t c = listHashCell(lst, listData(lst, ind));
+    size_t head = lst->hash.table[c];
+
+    chain[2*ind    ] = head;
+    chain[2*ind + 1] = 0;
+    if (head != 0){
+        chain[2*head + 1] = ind;
+    }
+    lst->hash.table[c] = ind;
+}
+
+//! removes node ind from value index (before its data is changed)
+template<typename T, typename Policy>
+static void listHashErase(List<T, Policy>* lst, size_t ind){
+    size_t* chain = lst->hash.chain;
+    size_t next = chain[2*ind];
+    size_t prev = chain[2*ind + 1];
+
+    if (next != 0){
+        chain[2*next + 1] = prev;
+    }
+    if (prev != 0){
+        chain[2*prev] = next;
+        return;
+    }
+
+    //cell is searched by index, not by value: values that are not equal to themselves (NaN) have own cells
+    size_t* table = lst->hash.table;
+    size_t mask = lst->hash.table_size - 1;
+    size_t c = ListElemHash<T>::hash(listData(lst, ind)) & mask;
+    while (table[c] != ind){
+        c = (c + 1) & mask;
+    }
+    if (next != 0){
+        table[c] = next;
+        return;
+    }
+
+    //backward shift deletion: move later cells of the probe run into the hole
+    size_t hole = c;
+    for (size_t j = (c + 1) & mask; table[j] != 0; j = (j + 1) & mask){
+        size_t home = ListElemHash<T>::hash(listData(lst, table[j])) & mask;
+        bool movable = (hole <= j) ? (home <= hole || home > j) : (home <= hole && home > j);
+        if (movable){
+            table[hole] = table[j];
+            hole = j;
+        }
+    }
+    table[hole] = 0;
+}
+
+//! reallocates value index for current capacity and fills it in O(size)
+template<typename T, typename Policy>
+static bool listHashBuild(List<T, Policy>* lst){
+    size_t table_size = 16;
+    while (table_size < 2 * (lst->capacity + 1)){
+        table_size *= 2;
+    }
+
+    if (!listAllocOrResize((void**)&(lst->hash.table), table_size * sizeof(size_t), 0) ||
+        !listAllocOrResize((void**)&(lst->hash.chain), 2 * (lst->capacity + 1) * sizeof(size_t), 0)){
+        return false;
+    }
+    lst->hash.table_size = table_size;
+    memset(lst->hash.table, 0, table_size * sizeof(size_t));
+
+    //walked from tail, so first node of every value in list order ends up in table
+    if (listHasMem(lst)){
+        for (size_t i = listPrev(lst, 0); i != 0; i = listPrev(lst, i)){
+            listHashInsert(lst, i);
+        }
+    }
+    return true;
+}
+
+//! error bits of one storage array
+template<typename T, typename Policy>
+static unsigned int listArrError(const List<T, Policy>* lst, bool probe, const void* arr, size_t elem_size){
+    unsigned int err = 0;
+    if (arr == nullptr)
+        return VAR_DATA_NULL;
+    if (probe && !isPtrWritable(listDataMemBegin(lst, arr), listArrMemSize(lst, elem_size, lst->capacity)))
+        return VAR_DATA_BAD;
+
+    if (Policy::canary){
+        if (!checkLCanary(arr))
+            err |= VAR_DATA_CANARY_L_BAD;
+        if (!checkRCanary(arr, (lst->capacity + 1) * elem_size))
+            err |= VAR_DATA_CANARY_R_BAD;
+    }
+    return err;
+}
+
+template<typename T, typename Policy>
+bool listCtor_(List<T, Policy>* lst){
+    if (Policy::check && !isPtrWritable(lst, sizeof(*lst))){
+        return false;
+    }
+
+    lst->data  = nullptr;
+    lst->prev  = nullptr;
+    lst->next  = nullptr;
+    lst->nodes = nullptr;
+
+    lst->fmem_stack = 0;
+    lst->fmem_end   = 1;
+
+    lst->capacity = 0;
+    lst->size = 0;
+    lst->sorted = true;
+
+    lst->compact_pos    = 0;
+    lst->compact_budget = 0;
+    lst->auto_shrink    = false;
+    lst->growth         = LIST_GROWTH_DEFAULT;
+    lst->map            = nullptr;
+
+    lst->rank.nodes = nullptr;
+    lst->rank.root  = 0;
+    lst->rank.seed  = (uint64_t)(size_t)lst;
+
+    lst->hash.table      = nullptr;
+    lst->hash.table_size = 0;
+    lst->hash.chain      = nullptr;
+
+    lst->pool = false;
+
+    listCheckInit(&(lst->check), Policy::check);
+
+    if (Policy::canary){
+        lst->leftcan  = CANARY_L;
+        lst->rightcan = CANARY_R;
+    }
+    return true;
+}
+
+template<typename T, typename Policy>
+void listSetInfo(List<T, Policy>* lst, VarInfo info){
+    if (Policy::varinfo){
+        lst->info = info;
+    }
+}
+
+//! listError without pointer probes if probe is false (O(1), see LIST_CHECK_CHEAP)
+template<typename T, typename Policy>
+static varError_t listError_(const List<T, Policy>* lst, bool probe){
+
+    if (lst == nullptr)
+        return VAR_NULL;
+
+    if (probe && !isPtrReadable(lst, sizeof(*lst)))
+        return VAR_BAD;
+
+    if (lst->capacity == SIZE_MAX || lst->data == LIST_DESTRUCT_PTR || lst->nodes == LIST_DESTRUCT_PTR)
+        return VAR_DEAD;
+
+
+    unsigned int err = 0;
+
+    if (lst->capacity != 0){
+        if (Policy::layout == LIST_LAYOUT_NODES){
+            err |= listArrError(lst, probe, lst->nodes, sizeof(typename List<T, Policy>::node_t));
+        }
+        else{
+            err |= listArrError(lst, probe, lst->data, sizeof(T));
+            err |= listArrError(lst, probe, lst->prev, sizeof(typename Policy::index_t));
+            err |= listArrError(lst, probe, lst->next, sizeof(typename Policy::index_t));
+        }
+    }
+
+    if (lst->fmem_stack >= lst->fmem_end ||
+        lst->size       >= lst->fmem_end ||
+        lst->fmem_end   > lst->capacity + 1 ||
+        lst->compact_pos > lst->size + 1 ||
+        (lst->rank.nodes != nullptr && lst->rank.nodes[lst->rank.root].count != lst->size))
+    {
+        err |= VAR_BADSTATE;
+    }
+
+    if (Policy::canary){
+        if (lst->leftcan != CANARY_L){
+            err |= VAR_CANARY_L_BAD;
+        }
+        if (lst->rightcan != CANARY_R){
+            err |= VAR_CANARY_R_BAD;
+        }
+    }
+
+    if (!(err & (VAR_DATA_BAD | VAR_DATA_NULL)) && listHasMem(lst)){
+        if (listNext(lst, 0) >= lst->fmem_end ||
+            listPrev(lst, 0) >= lst->fmem_end){
+            err |= VAR_BADSTATE;
+        }
+    }
+
+    if(err != 0){
+        err |= VAR_CORRUPT;
+    }
+
+    return (varError_t)err;
+}
+
+template<typename T, typename Policy>
+varError_t listError(const List<T, Policy>* lst){
+    return listError_(lst, true);
+}
+
+//! walks all links (LIST_CHECK_PARANOID): every node is linked both ways, is not free,
+//! and there are exactly size of them. List must pass listError first. Pool storage is skipped
+template<typename T, typename Policy>
+static varError_t listVerifyLinks(const List<T, Policy>* lst){
+    if (!listHasMem(lst) || lst->pool){
+        return VAR_NOERROR;
+    }
+    size_t count = 0;
+    size_t i = 0;
+    do{
+        size_t next = listNext(lst, i);
+        if (next >= lst->fmem_end || listPrev(lst, next) != i || (next != 0 && listPrev(lst, next) == next)){
+            return (varError_t)(VAR_BADSTATE | VAR_CORRUPT);
+        }
+        i = next;
+        count++;
+    } while (i != 0 && count <= lst->size);
+
+    if (i != 0 || count != lst->size + 1){
+        return (varError_t)(VAR_BADSTATE | VAR_CORRUPT);
+    }
+    return VAR_NOERROR;
+}
+
+//! check done by public operations, depth depends on check tier of list
+template<typename T, typename Policy>
+static varError_t listCheck(const List<T, Policy>* lst){
+    if (!listProtected(lst)){
+        return VAR_NOERROR;
+    }
+    if (lst == nullptr){
+        return VAR_NULL;
+    }
+    ListCheckTier depth = listCheckDepth(&(lst->check));
+    if (depth == LIST_CHECK_OFF){
+        return VAR_NOERROR;
+    }
+    uint64_t start = lst->check.timing ? listClockNs() : 0;
+    varError_t err = listError_(lst, depth != LIST_CHECK_CHEAP);
+    if (depth == LIST_CHECK_PARANOID && err == VAR_NOERROR){
+        err = listVerifyLinks(lst);
+    }
+    listCheckCount(&(lst->check), depth, start);
+    return err;
+}
+
+template<typename T, typename Policy>
+static varError_t listError_dbg(const List<T, Policy>* lst){
+    if (Policy::check)
+        return listError(lst);
+    return VAR_NOERROR;
+}
+
+template<typename T, typename Policy>
+static void listTextDump(const List<T, Policy>* lst){
+    char elem_str[LIST_ELEM_STR_LEN] = "";
+
+    printf_log("I |");
+    for (size_t i = 1; i <= lst->capacity; i++){
+        printf_log("%5lu", i);
+    }
+    printf_log("\nD |");
+    for (size_t i = 1; i <= lst->capacity; i++){
+        ListElemInfo<T>::print(elem_str, LIST_ELEM_STR_LEN, listData(lst, i));
+        printf_log("%5s", elem_str);
+    }
+    printf_log("\nP |");
+    for (size_t i = 1; i <= lst->capacity; i++){
+        printf_log("%5lu", listPrev(lst, i));
+    }
+    printf_log("\nN |");
+    for (size_t i = 1; i <= lst->capacity; i++){
+        printf_log("%5lu", listNext(lst, i));
+    }
+    printf_log("\n");
+
+    printf_log("list elements in order:\n");
+    size_t i = listNext(lst, 0);
+    while (i != 0 && i <= lst->capacity){
+        ListElemInfo<T>::print(elem_str, LIST_ELEM_STR_LEN, listData(lst, i));
+        printf_log("%s ", elem_str);
+        i = listNext(lst, i);
+    }
+    if (i != 0){
+        printf_log("...Bad pointer");
+    }
+    printf_log("\n");
+}
+
+template<typename T, typename Policy>
+static void listGraphDump(const List<T, Policy>* lst){
+    #define COLOR_NORM_LINE    "\"#f0f0f0\""
+    #define COLOR_NORM_TXT     "\"#f0f0f0\""
+    #define COLOR_NORM_FILL    "\"#25252F\""
+    #define COLOR_VALID_LINE   "\"#dad0ac\""
+    #define COLOR_INVALID_LINE "\"#ff3e3e\""
+
+    #define COLOR_FREE_S_LINE  "\"#00b4ed\""
+    #define COLOR_FREE_S_FILL  "\"#00384a\""
+    #define COLOR_FREE_E_LINE  "\"#4aec6d\""
+    #define COLOR_FREE_E_FILL  "\"#053500\""
+
+    char elem_str[LIST_ELEM_STR_LEN] = "";
+
+    FILE* graph_file = fopen("graph.tmp", "w");
+    if (graph_file == nullptr){
+        perror_log("can not create graph file");
+        return;
+    }
+    fprintf(graph_file, "digraph G{\n");
+    fprintf(graph_file, "rankdir=LR; bgcolor=\"#151515\";\n"
+                        "node[shape=rectangle, style=filled, fillcolor=" COLOR_NORM_FILL ", color=" COLOR_NORM_LINE ", fontcolor=" COLOR_NORM_TXT "]\n"
+                        "edge[weight=1, color=\"#f0f0f0\"]\n");
+
+    fprintf(graph_file, "\"N0\"[shape=diamond, label=\"[0]\", color=\"#6e00ff\"]\n");
+
+    //draw main nodes
+    for (size_t i = 1; i <= lst->capacity; i++){
+        const char* bgcolor   = COLOR_NORM_FILL;
+        const char* linecolor = COLOR_NORM_LINE;
+        if (listPrev(lst, i) == i){
+            linecolor = COLOR_FREE_S_LINE;
+            bgcolor   = COLOR_FREE_S_FILL;
+        }
+        if (i >= lst->fmem_end){
+            linecolor = COLOR_FREE_E_LINE;
+            bgcolor   = COLOR_FREE_E_FILL;
+        }
+
+        ListElemInfo<T>::print(elem_str, LIST_ELEM_STR_LEN, listData(lst, i));
+        fprintf(graph_file, "\"N%lu\"[shape=plaintext, style=solid, color = %s, "
+                "label=<<TABLE  BORDER=\"0\" CELLBORDER=\"1\" CELLSPACING=\"0\" BGCOLOR = %s>\n"
+                "<TR><TD>D: %s</TD></TR>\n"
+                "<TR><TD>P: %lu </TD></TR>\n"
+                "<TR><TD>N: %lu </TD></TR>\n"
+                "</TABLE>> ]\n"
+                , i, linecolor, bgcolor, elem_str, listPrev(lst, i), listNext(lst, i));
+    }
+    for (size_t i = 0; i < lst->capacity; i++){
+        fprintf(graph_file, "\"N%lu\"->", i);
+    }
+    fprintf(graph_file, "\"N%lu\"[style=dotted, dir=none, weight=1000]\n", lst->capacity);
+
+    // draw index nodes
+    size_t drawn_size = lst->capacity;
+    if (lst->fmem_end == drawn_size + 1)
+        drawn_size = lst->fmem_end;
+
+    for (size_t i = 0; i <= drawn_size; i++){
+        fprintf(graph_file, "\"I%lu\"[shape=plaintext, style=solid, label = \"[%lu]\"]\n", i, i);
+    }
+    for (size_t i = 0; i < drawn_size; i++){
+        fprintf(graph_file, "\"I%lu\"->", i);
+    }
+    fprintf(graph_file, "\"I%lu\"[style=dotted, dir=none, weight=1000]\n", drawn_size);
+
+
+    for (size_t i = 0; i <= lst->capacity; i++){
+        fprintf(graph_file, "{rank=same; \"I%lu\"; \"N%lu\"}", i, i);
+    }
+
+    //draw main edges
+    for(size_t i = 0; i < lst->fmem_end; i++){
+        fprintf(graph_file, "N%lu->N%lu[", i, listNext(lst, i));
+
+        if (listPrev(lst, i) == i){
+            fprintf(graph_file, "color=" COLOR_FREE_S_LINE ", style=dashed");
+        }
+        else{
+            if(listPrev(lst, listNext(lst, i)) == i){
+                fprintf(graph_file, "dir=both, arrowtail=crow, color=" COLOR_VALID_LINE );
+            }
+            else{
+                fprintf(graph_file, "color=" COLOR_INVALID_LINE);
+            }
+        }
+        fprintf(graph_file, "]\n");
+
+        if (listNext(lst, listPrev(lst, i)) != i){
+            fprintf(graph_file, "N%lu->N%lu[arrowhead=crow, constraint=false", i, listPrev(lst, i));
+            if (listPrev(lst, i) == i){
+                fprintf(graph_file, ",color=" COLOR_FREE_S_LINE ", style=dashed");
+            }
+            else{
+                fprintf(graph_file, ",color=" COLOR_INVALID_LINE);
+            }
+            fprintf(graph_file, "]\n");
+        }
+    }
+
+    // draw pointer nodes
+    fprintf(graph_file, "HEAD[shape=ellipse, color=grey]\n");
+    fprintf(graph_file, "HEAD->N%lu\n"                    , listNext(lst, 0));
+    fprintf(graph_file, "I%lu->HEAD[style=invis]\n"       , listNext(lst, 0));
+    fprintf(graph_file, "{rank=same; \"N%lu\"; \"HEAD\" }", listNext(lst, 0));
+
+    fprintf(graph_file, "TAIL[shape=ellipse, color=grey]\n");
+    fprintf(graph_file, "TAIL->N%lu[arrowhead=crow]\n"    , listPrev(lst, 0));
+    fprintf(graph_file, "I%lu->TAIL[style=invis]\n"       , listPrev(lst, 0));
+    fprintf(graph_file, "{rank=same; \"N%lu\"; \"TAIL\" }", listPrev(lst, 0));
+
+    fprintf(graph_file, "FREE_STK[shape=ellipse, color=" COLOR_FREE_S_LINE "]\n");
+    fprintf(graph_file, "FREE_STK->N%lu[color=" COLOR_FREE_S_LINE ", style=dashed]\n", lst->fmem_stack);
+    fprintf(graph_file, "I%lu->FREE_STK[style=invis]\n"                              , lst->fmem_stack);
+    fprintf(graph_file, "{rank=same; \"N%lu\"; \"FREE_STK\" }", lst->fmem_stack);
+
+    if (lst->fmem_end <= drawn_size){
+        fprintf(graph_file, "FREE_END[shape=ellipse, color=" COLOR_FREE_E_LINE "]\n");
+        fprintf(graph_file, "I%lu->FREE_END[style=invis]\n"                              , lst->fmem_end);
+        fprintf(graph_file, "{rank=same; \"I%lu\"; \"FREE_END\" }"                       , lst->fmem_end);
+    }
+    if (lst->fmem_end <= lst->capacity){
+        fprintf(graph_file, "FREE_END->N%lu[color=" COLOR_FREE_E_LINE ", style=dashed]\n", lst->fmem_end);
+    }
+
+    fprintf(graph_file, "}");
+    fclose(graph_file);
+
+    listRenderGraph("graph.tmp");
+
+    #undef COLOR_NORM_LINE
+    #undef COLOR_NORM_TXT
+    #undef COLOR_NORM_FILL
+    #undef COLOR_VALID_LINE
+    #undef COLOR_INVALID_LINE
+    #undef COLOR_FREE_S_LINE
+    #undef COLOR_FREE_S_FILL
+    #undef COLOR_FREE_E_LINE
+    #undef COLOR_FREE_E_FILL
+}
+
+template<typename T, typename Policy>
+void listDump(const List<T, Policy>* lst, bool graph_dump){
+    hline_log();
+    varError_t err = listError(lst);
+    if (err == VAR_NOERROR && lst->check.tier == LIST_CHECK_PARANOID){
+        err = listVerifyLinks(lst);
+    }
+    printf_log("List dump\n");
+    printf_log("    List at %p\n", lst);
+
+    bool ptr_ok = !(err & VAR_NULL || err & VAR_BAD);
+    if (!ptr_ok){
+        printBaseError_log((baseError_t) err);
+        hline_log();
+        return;
+    }
+
+    if (Policy::layout == LIST_LAYOUT_NODES){
+        printf_log("    Nodes: %p\n", lst->nodes);
+    }
+    else{
+        printf_log("    Data: %p\n", lst->data);
+        printf_log("    Prev: %p\n", lst->prev);
+        printf_log("    Next: %p\n", lst->next);
+    }
+    printf_log("    Sort: %s\n", lst->sorted ? "true" : "false");
+    if (Policy::check){
+        static const char* const tier_names[] = {"off", "cheap", "sampled", "paranoid"};
+        const ListCheckStats* stats = &(lst->check.stats);
+        printf_log("    Check tier: %s (every %lu)\n", tier_names[lst->check.tier & 3], lst->check.every);
+        printf_log("    Checks: cheap %llu (%llu ns) full %llu (%llu ns) paranoid %llu (%llu ns)\n",
+                   (unsigned long long)stats->cheap_count, (unsigned long long)stats->cheap_ns,
+                   (unsigned long long)stats->full_count , (unsigned long long)stats->full_ns,
+                   (unsigned long long)stats->deep_count , (unsigned long long)stats->deep_ns);
+    }
+
+    if (Policy::varinfo){
+        printVarInfo_log(&(lst->info));
+    }
+
+    if (err == VAR_NOERROR){
+       printf_log("    List ok\n");
+    }
+    else {
+       printf_log("    ERRORS:\n");
+    }
+
+    printBaseError_log((baseError_t) err);
+
+    if (err & VAR_DEAD){
+        hline_log();
+        return;
+    }
+
+    if (Policy::canary){
+        if (err & VAR_CANARY_L_BAD){
+            printf_log("     Left struct canary bad (%llX | %llX)\n", lst->leftcan , CANARY_L);
+        }
+        if (err & VAR_CANARY_R_BAD){
+            printf_log("     Right struct canary bad (%llX | %llX)\n", lst->rightcan , CANARY_R);
+        }
+    }
+    if (err & VAR_DATA_NULL){
+        printf_log("     Data pointer is null\n");
+        hline_log();
+        return;
+    }
+    if (err & VAR_DATA_BAD){
+        printf_log("     Data pointer is bad\n");
+        hline_log();
+        return;
+    }
+
+    if (!listHasMem(lst)){
+        printf_log("     List empty\n");
+        hline_log();
+        return;
+    }
+
+    printf_log("    Head: %lu Tail %lu Capacity %lu Size %lu\n", listNext(lst, 0), listPrev(lst, 0), lst->capacity, lst->size);
+    printf_log("    Free mem ptr: Stack: %lu Unused end: %lu\n", lst->fmem_stack, lst->fmem_end);
+    if (lst->compact_pos != 0){
+        printf_log("    Compaction: position %lu step %lu\n", lst->compact_pos, lst->compact_budget);
+    }
+    if (lst->rank.nodes != nullptr){
+        printf_log("    Rank index: root %lu\n", lst->rank.root);
+    }
+    if (lst->hash.table != nullptr){
+        printf_log("    Value index: %lu cells\n", lst->hash.table_size);
+    }
+
+    if (err & VAR_BADSTATE){
+        printf_log("     (BAD) List in invalid state (indexes out of range)\n");
+    }
+    if (Policy::canary && Policy::layout == LIST_LAYOUT_NODES){
+        size_t cap = lst->capacity;
+        if (err & VAR_DATA_CANARY_L_BAD){
+            printf_log("     Left data canary bad (%llX | %llX)\n",
+                        ((canary_t*)lst->nodes)[-1], CANARY_L);
+        }
+        if (err & VAR_DATA_CANARY_R_BAD){
+            printf_log("     Right data canary bad (%llX | %llX)\n",
+                       *(canary_t*)(lst->nodes + cap + 1), CANARY_R);
+        }
+    }
+    else if (Policy::canary){
+        size_t cap = lst->capacity;
+        if (err & VAR_DATA_CANARY_L_BAD){
+            printf_log("     Left data canary bad (D%llX-P%llX-N%llX | %llX)\n",
+                        ((canary_t*)lst->data)[-1], ((canary_t*)lst->prev)[-1], ((canary_t*)lst->next)[-1], CANARY_L);
+        }
+        if (err & VAR_DATA_CANARY_R_BAD){
+            printf_log("     Right data canary bad (D%llX-P%llX-N%llX | %llX)\n",
+                       *(canary_t*)(lst->data + cap + 1), *(canary_t*)(lst->prev + cap + 1), *(canary_t*)(lst->next + cap + 1), CANARY_R);
+        }
+    }
+
+
+    if (graph_dump){
+        listGraphDump(lst);
+    }
+    else{
+        listTextDump(lst);
+    }
+    hline_log();
+}
+
+template<typename T, typename Policy>
+varError_t listDtor(List<T, Policy>* lst){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (listHasMem(lst)){
+        //file-backed list keeps its elements
+        if (Policy::poison && lst->map == nullptr){
+            for (size_t i = 0; i <= lst->capacity; i++){
+                listData(lst, i) = ListElemInfo<T>::bad();
+            }
+        }
+        listMemFree(lst);
+    }
+    listRankIndexDisable(lst);
+    listHashIndexDisable(lst);
+
+    lst->data  = (T*)          LIST_DESTRUCT_PTR;
+    lst->prev  = (typename Policy::index_t*)         LIST_DESTRUCT_PTR;
+    lst->next  = (typename Policy::index_t*)         LIST_DESTRUCT_PTR;
+    lst->nodes = (typename List<T, Policy>::node_t*) LIST_DESTRUCT_PTR;
+    lst->capacity = -1;
+    if (Policy::varinfo){
+        (lst->info).status = VARSTATUS_DEAD;
+    }
+    return VAR_NOERROR;
+}
+
+//! listResize without validation, for callers which already checked the list
+template<typename T, typename Policy>
+static varError_t listResize_(List<T, Policy>* lst, size_t new_capacity){
+    if (new_capacity < lst->fmem_end - 1 || new_capacity > listMaxCapacity(lst)){
+        return VAR_BADOP;
+    }
+
+    if (listMemResize(lst, new_capacity)) {
+
+        size_t t = lst->capacity;
+        lst->capacity = new_capacity;
+
+        if (t == 0){
+            listNext(lst, 0) = 0;
+            listPrev(lst, 0) = 0;
+        }
+
+        if (lst->rank.nodes != nullptr && !listRankMemResize(lst, t, new_capacity)){
+            Error_log("%s", "can not resize rank index, it is disabled\n");
+            listRankIndexDisable(lst);
+        }
+        if (lst->hash.table != nullptr && !listHashBuild(lst)){
+            Error_log("%s", "can not resize value index, it is disabled\n");
+            listHashIndexDisable(lst);
+        }
+
+        if (Policy::poison){
+            for(size_t i = t + 1; i <= new_capacity; i++){
+                listData(lst, i) = ListElemInfo<T>::bad();
+                listPrev(lst, i) = 0;
+                listNext(lst, i) = 0;
+            }
+        }
+
+        listReplaceDataCanary(lst);
+        return VAR_NOERROR;
+    }
+    else {
+        Error_log("%s", "error while resizing list\n");
+        return VAR_INTERR;
+    }
+}
+
+template<typename T, typename Policy>
+varError_t listResize(List<T, Policy>* lst, size_t new_capacity){
+    listCheckRet(lst, listError_dbg(lst));
+    return listResize_(lst, new_capacity);
+}
+
+template<typename T, typename Policy>
+void listSetGrowth(List<T, Policy>* lst, ListGrowth growth){
+    lst->growth = growth;
+}
+
+template<typename T, typename Policy>
+void listSetGrowthHint(List<T, Policy>* lst, size_t expected_size){
+    lst->growth.hint = expected_size;
+}
+
+//! capacity to grow to when list needs need_cap slots (result is at least need_cap unless it is over max)
+template<typename T, typename Policy>
+static size_t listGrowCapacity(const List<T, Policy>* lst, size_t need_cap){
+    return listGrowthCapacity(&(lst->growth), lst->capacity, need_cap, listMaxCapacity(lst));
+}
+
+template<typename T, typename Policy>
+static void listAddFreeMem(List<T, Policy>* lst, size_t ind){
+    listPrev(lst, ind) = ind;
+    if (lst->compact_pos != 0){
+        //slot is reclaimed when compaction finishes
+        return;
+    }
+    listNext(lst, ind) = lst->fmem_stack;
+    lst->fmem_stack = ind;
+    return;
+}
+
+template<typename T, typename Policy>
+static size_t listGetFreeMem(List<T, Policy>* lst){
+    if (lst->fmem_stack == 0){
+        if(lst->fmem_end <= lst->capacity)
+            return lst->fmem_end++;
+        else
+            return 0;
+    }
+    else {
+        size_t t = lst->fmem_stack;
+        lst->fmem_stack = listNext(lst, t);
+        return t;
+    }
+}
+
+//! Incremental compaction.
+//! Slots 1..compact_pos-1 already hold logical positions 1..compact_pos-1.
+//! While compaction runs, free stack is dropped and freed slots are not pushed back:
+//! free slots below fmem_end are found by their marks (see List).
+//! When compact_pos passes size, everything above size is free: fmem_end = size + 1.
+
+//! mutation at logical position pos (in compacted prefix) invalidates prefix after it
+template<typename T, typename Policy>
+static void listCompactTouch(List<T, Policy>* lst, size_t pos){
+    if (lst->compact_pos != 0 && pos < lst->compact_pos){
+        lst->compact_pos = (pos == 0) ? 1 : pos;
+    }
+}
+
+//! exchanges physical slots a and b of two live nodes, logical order is kept
+template<typename T, typename Policy>
+static void listSwapSlots(List<T, Policy>* lst, size_t a, size_t b){
+    if (lst->hash.table != nullptr){
+        listHashErase(lst, a);
+        listHashErase(lst, b);
+    }
+
+    #define SWAPPED_(_i) ((_i) == a ? b : ((_i) == b ? a : (_i)))
+    size_t ap = SWAPPED_(listPrev(lst, a));
+    size_t an = SWAPPED_(listNext(lst, a));
+    size_t bp = SWAPPED_(listPrev(lst, b));
+    size_t bn = SWAPPED_(listNext(lst, b));
+    #undef SWAPPED_
+
+    T t = listData(lst, a);
+    listData(lst, a) = listData(lst, b);
+    listData(lst, b) = t;
+
+    listPrev(lst, b) = ap;
+    listNext(lst, b) = an;
+    listPrev(lst, a) = bp;
+    listNext(lst, a) = bn;
+
+    listNext(lst, ap) = b;
+    listPrev(lst, an) = b;
+    listNext(lst, bp) = a;
+    listPrev(lst, bn) = a;
+
+    if (lst->rank.nodes != nullptr){
+        listRankSwapSlots(&(lst->rank), a, b);
+    }
+    if (lst->hash.table != nullptr){
+        listHashInsert(lst, a);
+        listHashInsert(lst, b);
+    }
+}
+
+//! moves live node from slot a to free slot b
+template<typename T, typename Policy>
+static void listMoveSlot(List<T, Policy>* lst, size_t a, size_t b){
+    if (lst->hash.table != nullptr){
+        listHashErase(lst, a);
+    }
+
+    size_t ap = listPrev(lst, a);
+    size_t an = listNext(lst, a);
+
+    listData(lst, b) = listData(lst, a);
+    listPrev(lst, b) = ap;
+    listNext(lst, b) = an;
+    listNext(lst, ap) = b;
+    listPrev(lst, an) = b;
+
+    if (Policy::poison){
+        listData(lst, a) = ListElemInfo<T>::bad();
+    }
+    listPrev(lst, a) = a;
+
+    if (lst->rank.nodes != nullptr){
+        listRankSwapSlots(&(lst->rank), a, b);
+    }
+    if (lst->hash.table != nullptr){
+        listHashInsert(lst, b);
+    }
+}
+
+template<typename T, typename Policy>
+static void listShrinkFinish(List<T, Policy>* lst);
+
+template<typename T, typename Policy>
+static void listCompactFinish(List<T, Policy>* lst){
+    if (Policy::poison){
+        for (size_t i = lst->size + 1; i < lst->fmem_end; i++){
+            listData(lst, i) = ListElemInfo<T>::bad();
+            listPrev(lst, i) = 0;
+            listNext(lst, i) = 0;
+        }
+    }
+    lst->fmem_end    = lst->size + 1;
+    lst->fmem_stack  = 0;
+    lst->compact_pos = 0;
+    lst->sorted      = true;
+
+    listShrinkFinish(lst);
+}
+
+//! does up to budget units of compaction work, returns true if list is compacted
+template<typename T, typename Policy>
+static bool listCompactStep_(List<T, Policy>* lst, size_t budget){
+    if (lst->sorted || !listHasMem(lst)){
+        lst->compact_pos = 0;
+        return true;
+    }
+    if (lst->compact_pos == 0){
+        lst->compact_pos = 1;
+    }
+
+    //free slots are found by their marks while compaction runs, stack is dropped
+    lst->fmem_stack = 0;
+
+    while (budget > 0){
+        size_t k = lst->compact_pos;
+        if (k > lst->size){
+            listCompactFinish(lst);
+            return true;
+        }
+
+        size_t x = listNext(lst, k - 1);
+        if (x != k){
+            if (listPrev(lst, k) != k)
+                listSwapSlots(lst, x, k);
+            else
+                listMoveSlot(lst, x, k);
+        }
+        lst->compact_pos++;
+        budget--;
+    }
+
+    if (lst->fmem_stack == 0 && lst->compact_pos > lst->size){
+        listCompactFinish(lst);
+        return true;
+    }
+    return false;
+}
+
+//! Auto shrink
+
+template<typename T, typename Policy>
+static bool listShrinkWanted(const List<T, Policy>* lst){
+    return lst->auto_shrink && lst->capacity > LIST_SHRINK_MIN_CAPACITY &&
+           lst->size < lst->capacity / LIST_SHRINK_RATIO;
+}
+
+//! cuts capacity of compacted list, called when compaction finishes
+template<typename T, typename Policy>
+static void listShrinkFinish(List<T, Policy>* lst){
+    if (!listShrinkWanted(lst)){
+        return;
+    }
+    size_t new_cap = 2 * lst->size;
+    if (new_cap < LIST_SHRINK_MIN_CAPACITY){
+        new_cap = LIST_SHRINK_MIN_CAPACITY;
+    }
+    if (listResize_(lst, new_cap) != VAR_NOERROR){
+        Error_log("%s", "can not shrink list\n");
+    }
+}
+
+//! checked after every deletion: starts compaction which ends with shrinking
+template<typename T, typename Policy>
+static void listShrinkAuto(List<T, Policy>* lst){
+    if (!listShrinkWanted(lst)){
+        return;
+    }
+    if (lst->sorted && lst->compact_pos == 0){
+        listCompactFinish(lst);
+        return;
+    }
+    //work (whole storage) is spread over mutations in proportion to free space
+    size_t budget = LIST_SHRINK_BUDGET * (lst->capacity / (lst->size + 1));
+    if (lst->compact_pos == 0){
+        lst->compact_pos = 1;
+    }
+    if (lst->compact_budget < budget){
+        lst->compact_budget = budget;
+    }
+}
+
+//! auto compaction step done by every mutation
+template<typename T, typename Policy>
+static void listCompactAuto(List<T, Policy>* lst){
+    if (lst->compact_pos != 0 && lst->compact_budget != 0){
+        listCompactStep_(lst, lst->compact_budget);
+    }
+}
+
+template<typename T, typename Policy>
+size_t listPushAfter(List<T, Policy>* lst, size_t ind, T elem, varError_t* err_ptr){
+    listCheckRetPtr(lst, err_ptr, 0);
+
+    if(ind >= lst->fmem_end || (listHasMem(lst) && listPrev(lst, ind) == ind && ind != 0)){
+        if (err_ptr)
+            *err_ptr = VAR_BADOP;
+        return 0;
+    }
+
+    size_t ni = listGetFreeMem(lst);
+
+    if (ni == 0){
+        if (lst->capacity >= listMaxCapacity(lst)){
+            if (err_ptr)
+                *err_ptr = VAR_BADOP;
+            return 0;
+        }
+
+        varError_t err = listResize_(lst, listGrowCapacity(lst, lst->capacity + 1));
+        if (err != VAR_NOERROR){
+            if (err_ptr)
+                *err_ptr = err;
+            return 0;
+        }
+
+        ni = listGetFreeMem(lst);
+        if (ni == 0){
+            if (err_ptr)
+                *err_ptr = VAR_ERRUNK;
+            return 0;
+        }
+    }
+
+    if(ind != listPrev(lst, 0) || ni != lst->size + 1){
+        lst->sorted = false;
+    }
+    listCompactTouch(lst, ind + 1);
+
+    lst->size++;
+
+    listData(lst, ni) = elem;
+    listPrev(lst, ni) = ind;
+
+    listNext(lst, ni) = listNext(lst, ind);
+    listPrev(lst, listNext(lst, ind)) = ni;
+    listNext(lst, ind) = ni;
+
+    if (lst->rank.nodes != nullptr){
+        listRankInsertAfter(&(lst->rank), ni, ind);
+    }
+    if (lst->hash.table != nullptr){
+        listHashInsert(lst, ni);
+    }
+    listCompactAuto(lst);
+    return ni;
+}
+
+template<typename T, typename Policy>
+size_t listInsertRangeAfter(List<T, Policy>* lst, size_t ind, const T* src, size_t n, varError_t* err_ptr){
+    listCheckRetPtr(lst, err_ptr, 0);
+
+    if(src == nullptr || n == 0 || ind >= lst->fmem_end ||
+       (listHasMem(lst) && listPrev(lst, ind) == ind && ind != 0)){
+        if (err_ptr)
+            *err_ptr = VAR_BADOP;
+        return 0;
+    }
+
+    //freed slots are reused before list grows; while compaction runs they are not on free stack
+    size_t need_cap = ((lst->compact_pos != 0) ? lst->fmem_end - 1 : lst->size) + n;
+    if (need_cap > listMaxCapacity(lst)){
+        if (err_ptr)
+            *err_ptr = VAR_BADOP;
+        return 0;
+    }
+    if (need_cap > lst->capacity){
+        varError_t err = listResize_(lst, listGrowCapacity(lst, need_cap));
+        if (err != VAR_NOERROR){
+            if (err_ptr)
+                *err_ptr = err;
+            return 0;
+        }
+    }
+
+    size_t after = listNext(lst, ind);
+    if (lst->fmem_end - 1 + n > lst->capacity){
+        //unused end is too short: nodes go to free slots one by one (stack first, then end)
+        lst->sorted = false;
+        size_t first = 0;
+        size_t last  = ind;
+        for (size_t i = 0; i < n; i++){
+            size_t ni = listGetFreeMem(lst);
+            listData(lst, ni) = src[i];
+            listPrev(lst, ni  ) = last;
+            listNext(lst, last) = ni;
+            if (lst->rank.nodes != nullptr){
+                listRankInsertAfter(&(lst->rank), ni, last);
+            }
+            first = (i == 0) ? ni : first;
+            last  = ni;
+        }
+        listNext(lst, last ) = after;
+        listPrev(lst, after) = last;
+
+        lst->size += n;
+        if (lst->hash.table != nullptr){
+            for (size_t i = first; i != after; i = listNext(lst, i)){
+                listHashInsert(lst, i);
+            }
+        }
+        listCompactTouch(lst, ind + 1);
+        listCompactAuto(lst);
+        return first;
+    }
+
+    //enough unused end: new nodes form one physical run
+    if (ind != listPrev(lst, 0) || lst->fmem_end != lst->size + 1){
+        lst->sorted = false;
+    }
+
+    size_t first = lst->fmem_end;
+    size_t last  = first + n - 1;
+    lst->fmem_end += n;
+
+    for (size_t i = 0; i < n; i++){
+        size_t ni = first + i;
+        listData(lst, ni) = src[i];
+        listPrev(lst, ni) = ni - 1;
+        listNext(lst, ni) = ni + 1;
+    }
+    listPrev(lst, first) = ind;
+    listNext(lst, last ) = after;
+
+    listNext(lst, ind  ) = first;
+    listPrev(lst, after) = last;
+
+    lst->size += n;
+    if (lst->rank.nodes != nullptr){
+        for (size_t i = 0; i < n; i++){
+            listRankInsertAfter(&(lst->rank), first + i, (i == 0) ? ind : first + i - 1);
+        }
+    }
+    if (lst->hash.table != nullptr){
+        for (size_t i = first; i <= last; i++){
+            listHashInsert(lst, i);
+        }
+    }
+    listCompactTouch(lst, ind + 1);
+    listCompactAuto(lst);
+    return first;
+}
+
+template<typename T, typename Policy>
+varError_t listDeleteElem(List<T, Policy>* lst, size_t ind){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (ind == 0 || ind >= lst->fmem_end || !listHasMem(lst) || listPrev(lst, ind) == ind){
+        return VAR_BADOP;
+    }
+
+    if (ind != listPrev(lst, 0)){
+        lst->sorted = false;
+    }
+
+    lst->size--;
+    listNext(lst, listPrev(lst, ind)) = listNext(lst, ind);
+
+    listPrev(lst, listNext(lst, ind)) = listPrev(lst, ind);
+
+    if (lst->rank.nodes != nullptr){
+        listRankErase(&(lst->rank), ind);
+    }
+    if (lst->hash.table != nullptr){
+        listHashErase(lst, ind);
+    }
+
+    if (Policy::poison){
+        listData(lst, ind) = ListElemInfo<T>::bad();
+    }
+
+    listAddFreeMem(lst, ind);
+    listCompactTouch(lst, ind);
+    listShrinkAuto(lst);
+    listCompactAuto(lst);
+    return VAR_NOERROR;
+}
+
+//! number of nodes in [first, last] range (walks next links), 0 if last is not reachable from first
+template<typename T, typename Policy>
+static size_t listRangeLength(const List<T, Policy>* lst, size_t first, size_t last){
+    size_t len = 1;
+    size_t i = first;
+    while (i != last){
+        i = listNext(lst, i);
+        if (i == 0 || len > lst->size)
+            return 0;
+        len++;
+    }
+    return len;
+}
+
+template<typename T, typename Policy>
+static bool listIsLive(const List<T, Policy>* lst, size_t ind){
+    return ind != 0 && ind < lst->fmem_end && listPrev(lst, ind) != ind;
+}
+
+template<typename T, typename Policy>
+varError_t listEraseRange(List<T, Policy>* lst, size_t first, size_t last, size_t count){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (!listHasMem(lst) || !listIsLive(lst, first) || !listIsLive(lst, last)){
+        return VAR_BADOP;
+    }
+
+    if (Policy::check || count == 0){
+        size_t len = listRangeLength(lst, first, last);
+        if (len == 0 || (count != 0 && count != len)){
+            return VAR_BADOP;
+        }
+        count = len;
+    }
+
+    if (last != listPrev(lst, 0)){
+        lst->sorted = false;
+    }
+
+    if (lst->rank.nodes != nullptr){
+        for (size_t i = first; i != listNext(lst, last); i = listNext(lst, i)){
+            listRankErase(&(lst->rank), i);
+        }
+    }
+    if (lst->hash.table != nullptr){
+        for (size_t i = first; i != listNext(lst, last); i = listNext(lst, i)){
+            listHashErase(lst, i);
+        }
+    }
+
+    size_t before = listPrev(lst, first);
+    size_t after  = listNext(lst, last);
+    listNext(lst, before) = after;
+    listPrev(lst, after ) = before;
+    lst->size -= count;
+
+    //freed slots are marked like in listAddFreeMem
+    for (size_t i = first; i != after; ){
+        size_t t = listNext(lst, i);
+        if (Policy::poison){
+            listData(lst, i) = ListElemInfo<T>::bad();
+        }
+        listPrev(lst, i) = i;
+        i = t;
+    }
+
+    if (lst->compact_pos != 0){
+        //slots are reclaimed when compaction finishes
+        listCompactTouch(lst, first);
+        listCompactAuto(lst);
+        return VAR_NOERROR;
+    }
+
+    //removed run is already chained by next links, so it goes to free stack at once
+    listNext(lst, last) = lst->fmem_stack;
+    lst->fmem_stack = first;
+
+    listShrinkAuto(lst);
+    listCompactAuto(lst);
+    return VAR_NOERROR;
+}
+
+template<typename T, typename Policy>
+varError_t listSplice(List<T, Policy>* lst, size_t dst_pos, size_t first, size_t last){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (!listHasMem(lst) || !listIsLive(lst, first) || !listIsLive(lst, last) ||
+        dst_pos >= lst->fmem_end || (dst_pos != 0 && listPrev(lst, dst_pos) == dst_pos)){
+        return VAR_BADOP;
+    }
+
+    if (Policy::check){
+        size_t len = listRangeLength(lst, first, last);
+        if (len == 0){
+            return VAR_BADOP;
+        }
+        for (size_t i = first; i != listNext(lst, last); i = listNext(lst, i)){
+            if (i == dst_pos)
+                return VAR_BADOP;
+        }
+    }
+
+    size_t before = listPrev(lst, first);
+    if (before == dst_pos){
+        return VAR_NOERROR;
+    }
+
+    lst->sorted = false;
+
+    size_t after = listNext(lst, last);
+    if (lst->rank.nodes != nullptr){
+        for (size_t i = first; i != after; i = listNext(lst, i)){
+            listRankErase(&(lst->rank), i);
+        }
+    }
+
+    listNext(lst, before) = after;
+    listPrev(lst, after ) = before;
+
+    size_t dst_next = listNext(lst, dst_pos);
+    listNext(lst, dst_pos ) = first;
+    listPrev(lst, first   ) = dst_pos;
+    listNext(lst, last    ) = dst_next;
+    listPrev(lst, dst_next) = last;
+
+    if (lst->rank.nodes != nullptr){
+        for (size_t i = first, p = dst_pos; i != dst_next; p = i, i = listNext(lst, i)){
+            listRankInsertAfter(&(lst->rank), i, p);
+        }
+    }
+
+    listCompactTouch(lst, first);
+    listCompactTouch(lst, dst_pos + 1);
+    listCompactAuto(lst);
+    return VAR_NOERROR;
+}
+
+template<typename T, typename Policy>
+varError_t listClear(List<T, Policy>* lst){
+    listCheckRet(lst, listError_dbg(lst));
+
+    lst->size       = 0;
+    lst->fmem_stack = 0;
+    lst->fmem_end   = 1;
+    lst->sorted     = true;
+    lst->compact_pos = 0;
+
+    if (lst->rank.nodes != nullptr){
+        memset(lst->rank.nodes, 0, (lst->capacity + 1) * sizeof(ListRankNode));
+        lst->rank.root = 0;
+    }
+    if (lst->hash.table != nullptr){
+        memset(lst->hash.table, 0, lst->hash.table_size * sizeof(size_t));
+    }
+
+    if (!listHasMem(lst)){
+        return VAR_NOERROR;
+    }
+
+    listNext(lst, 0) = 0;
+    listPrev(lst, 0) = 0;
+
+    if (Policy::poison){
+        for(size_t i = 1; i <= lst->capacity; i++){
+            listData(lst, i) = ListElemInfo<T>::bad();
+            listPrev(lst, i) = 0;
+            listNext(lst, i) = 0;
+        }
+    }
+    return VAR_NOERROR;
+}
+
+template<typename T, typename Policy>
+varError_t listCompactBegin(List<T, Policy>* lst, size_t auto_budget){
+    listCheckRet(lst, listError_dbg(lst));
+
+    lst->compact_budget = auto_budget;
+    if (!lst->sorted && lst->compact_pos == 0){
+        lst->compact_pos = 1;
+    }
+    return VAR_NOERROR;
+}
+
+template<typename T, typename Policy>
+bool listCompactStep(List<T, Policy>* lst, size_t budget, varError_t* err_ptr){
+    listCheckRetPtr(lst, err_ptr, false);
+
+    return listCompactStep_(lst, budget);
+}
+
+template<typename T, typename Policy>
+varError_t listSerialize(List<T, Policy>* lst, size_t new_size){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (new_size < lst->size || new_size > listMaxCapacity(lst)){
+        return VAR_BADOP;
+    }
+
+    if (listHasMem(lst)){
+        //verify chain before it is destroyed
+        size_t len = 0;
+        for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i)){
+            if (i >= lst->fmem_end || len >= lst->size){
+                return VAR_CORRUPT;
+            }
+            len++;
+        }
+        if (len != lst->size){
+            return VAR_CORRUPT;
+        }
+
+        //prev is reused as target slot of every node: free slots get 0, nodes get their logical position
+        for (size_t i = 1; i < lst->fmem_end; i++){
+            if (listPrev(lst, i) == i){
+                listPrev(lst, i) = 0;
+            }
+        }
+        size_t pos = 1;
+        for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i)){
+            listPrev(lst, i) = pos++;
+        }
+
+        //cycle-following permutation: every swap puts one node to its final slot
+        for (size_t i = 1; i < lst->fmem_end; i++){
+            while (listPrev(lst, i) != 0 && listPrev(lst, i) != i){
+                size_t j = listPrev(lst, i);
+
+                T t = listData(lst, i);
+                listData(lst, i) = listData(lst, j);
+                listData(lst, j) = t;
+
+                listPrev(lst, i) = listPrev(lst, j);
+                listPrev(lst, j) = j;
+            }
+        }
+
+        for(size_t i = 1; i <= lst->size; i++){
+            listPrev(lst, i  ) = i-1;
+            listNext(lst, i-1) = i;
+        }
+        listNext(lst, lst->size) = 0;
+        listPrev(lst, 0        ) = lst->size;
+
+        if (lst->rank.nodes != nullptr){
+            listRankBuild(lst);
+        }
+        if (lst->hash.table != nullptr && !listHashBuild(lst)){
+            listHashIndexDisable(lst);
+        }
+
+        if (Policy::poison){
+            for(size_t i = lst->size + 1; i < lst->fmem_end; i++){
+                listData(lst, i) = ListElemInfo<T>::bad();
+                listPrev(lst, i) = 0;
+                listNext(lst, i) = 0;
+            }
+        }
+    }
+
+    lst->sorted = true;
+    lst->fmem_end = lst->size + 1;
+    lst->fmem_stack = 0;
+    lst->compact_pos = 0;
+
+    if (new_size != lst->capacity){
+        return listResize_(lst, new_size);
+    }
+    return VAR_NOERROR;
+}
+
+template<typename T, typename Policy>
+varError_t listShrinkToFit(List<T, Policy>* lst){
+    return listSerialize(lst, lst->size);
+}
+
+template<typename T, typename Policy>
+void listSetAutoShrink(List<T, Policy>* lst, bool enable){
+    lst->auto_shrink = enable;
+}
+
+template<typename T, typename Policy>
+varError_t listSetCheckTier(List<T, Policy>* lst, ListCheckTier tier, size_t every, size_t interval_ms){
+    if (!Policy::check && tier != LIST_CHECK_OFF){
+        return VAR_BADOP;
+    }
+    return listCheckSetTier(&(lst->check), tier, every, interval_ms);
+}
+
+template<typename T, typename Policy>
+void listSetCheckTiming(List<T, Policy>* lst, bool enable){
+    lst->check.timing = enable;
+}
+
+template<typename T, typename Policy>
+ListCheckStats listCheckStats(const List<T, Policy>* lst){
+    return lst->check.stats;
+}
+
+template<typename T, typename Policy>
+void listResetCheckStats(List<T, Policy>* lst){
+    lst->check.stats = {};
+}
+
+template<typename T, typename Policy>
+size_t listReleaseFreeMem(List<T, Policy>* lst){
+    listCheckRet(lst, 0);
+
+    if (!listHasMem(lst)){
+        return 0;
+    }
+    size_t released = 0;
+
+    //never used end: slots fmem_end..capacity
+    size_t tail = lst->capacity + 1 - lst->fmem_end;
+    if (Policy::layout == LIST_LAYOUT_NODES){
+        released += listReleasePages(lst->nodes + lst->fmem_end, tail * sizeof(lst->nodes[0]));
+    }
+    else{
+        released += listReleasePages(lst->data + lst->fmem_end, tail * sizeof(T));
+        released += listReleasePages(lst->next + lst->fmem_end, tail * sizeof(lst->next[0]));
+        released += listReleasePages(lst->prev + lst->fmem_end, tail * sizeof(lst->prev[0]));
+    }
+    if (Policy::layout == LIST_LAYOUT_NODES){
+        return released;
+    }
+
+    //free runs in the middle
+    size_t slots = lst->fmem_end;
+    for (size_t i = 1; i < slots; ){
+        if (listPrev(lst, i) != i){
+            i++;
+            continue;
+        }
+        size_t run = i;
+        while (i < slots && listPrev(lst, i) == i){
+            i++;
+        }
+        released += listReleasePages(lst->data + run, (i - run) * sizeof(T));
+    }
+
+    return released;
+}
+
+//! merges two sorted chains linked by next only (0-terminated), returns head of result.
+//! Stable: on equal elements node of a goes first
+template<typename T, typename Policy, typename Cmp>
+static size_t listMergeChains(List<T, Policy>* lst, size_t a, size_t b, Cmp& cmp){
+    size_t head = 0;
+    size_t tail = 0;
+    while (a != 0 && b != 0){
+        size_t take = 0;
+        if (cmp(listData(lst, b), listData(lst, a))){
+            take = b;
+            b = listNext(lst, b);
+        }
+        else{
+            take = a;
+            a = listNext(lst, a);
+        }
+        if (tail == 0)
+            head = take;
+        else
+            listNext(lst, tail) = take;
+        tail = take;
+    }
+    size_t rest = (a != 0) ? a : b;
+    if (tail == 0)
+        return rest;
+    listNext(lst, tail) = rest;
+    return head;
+}
+
+//! makes chain starting at head the list: restores prev links, sentinel and rank index.
+//! Sets sorted if nodes happen to be at slots 1..size in order
+template<typename T, typename Policy>
+static void listRelinkChain(List<T, Policy>* lst, size_t head){
+    bool in_order = true;
+    size_t prev = 0;
+    listNext(lst, 0) = head;
+    for (size_t i = head; i != 0; i = listNext(lst, i)){
+        listPrev(lst, i) = prev;
+        in_order = in_order && (i == prev + 1);
+        prev = i;
+    }
+    listPrev(lst, 0) = prev;
+
+    lst->sorted = in_order;
+    listCompactTouch(lst, 1);
+    if (lst->rank.nodes != nullptr){
+        listRankBuild(lst);
+    }
+}
+
+template<typename T, typename Policy, typename Cmp>
+varError_t listSort(List<T, Policy>* lst, Cmp cmp){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (!listHasMem(lst)){
+        return VAR_NOERROR;
+    }
+
+    //already sorted in storage: data is one array, sort it in place
+    if (lst->sorted && Policy::layout == LIST_LAYOUT_SPLIT){
+        std::stable_sort(lst->data + 1, lst->data + 1 + lst->size, cmp);
+        if (lst->hash.table != nullptr && !listHashBuild(lst)){
+            listHashIndexDisable(lst);
+        }
+        return VAR_NOERROR;
+    }
+
+    //bottom-up merge sort: bins[k] holds a sorted run of 2^k nodes (or is empty),
+    //older runs are always merged as first argument to keep it stable
+    size_t bins[64] = {};
+    size_t used = 0;
+    size_t cur = listNext(lst, 0);
+    while (cur != 0){
+        size_t next = listNext(lst, cur);
+        listNext(lst, cur) = 0;
+
+        size_t run = cur;
+        size_t k = 0;
+        while (k < used && bins[k] != 0){
+            run = listMergeChains(lst, bins[k], run, cmp);
+            bins[k] = 0;
+            k++;
+        }
+        bins[k] = run;
+        if (k == used)
+            used++;
+        cur = next;
+    }
+    size_t head = 0;
+    for (size_t k = 0; k < used; k++){
+        if (bins[k] != 0)
+            head = listMergeChains(lst, bins[k], head, cmp);
+    }
+    listRelinkChain(lst, head);
+
+    return listSerialize(lst, lst->capacity);
+}
+
+template<typename T, typename Policy, typename Cmp>
+varError_t listMerge(List<T, Policy>* dst, List<T, Policy>* src, Cmp cmp){
+    listCheckRet(dst, listError_dbg(dst));
+    listCheckRet(src, listError_dbg(src));
+
+    if (dst == src){
+        return VAR_BADOP;
+    }
+    size_t n = src->size;
+    if (n == 0){
+        return VAR_NOERROR;
+    }
+
+    size_t need_cap = dst->fmem_end - 1 + n;
+    if (need_cap > listMaxCapacity(dst)){
+        return VAR_BADOP;
+    }
+    if (need_cap > dst->capacity){
+        varError_t err = listResize_(dst, listGrowCapacity(dst, need_cap));
+        if (err != VAR_NOERROR){
+            return err;
+        }
+    }
+
+    //copy of src as a 0-terminated chain in one physical run
+    size_t first = dst->fmem_end;
+    size_t k = first;
+    for (size_t i = listNext(src, 0); i != 0; i = listNext(src, i), k++){
+        listData(dst, k) = listData(src, i);
+        listNext(dst, k) = k + 1;
+    }
+    listNext(dst, k - 1) = 0;
+    dst->fmem_end = k;
+    dst->size += n;
+
+    if (dst->size != n){
+        listNext(dst, listPrev(dst, 0)) = 0;
+    }
+    size_t head = listMergeChains(dst, listNext(dst, 0), first, cmp);
+    listRelinkChain(dst, head);
+
+    if (dst->hash.table != nullptr){
+        for (size_t i = first; i < k; i++){
+            listHashInsert(dst, i);
+        }
+    }
+    listCompactAuto(dst);
+
+    return listClear(src);
+}
+
+//! walks from node ind at position from to position to (sentinel is position 0 and size + 1)
+template<typename T, typename Policy>
+static size_t listWalk(const List<T, Policy>* lst, size_t ind, size_t from, size_t to){
+    while (from < to){
+        ind = listNext(lst, ind);
+        from++;
+    }
+    while (from > to){
+        ind = listPrev(lst, ind);
+        from--;
+    }
+    return ind;
+}
+
+template<typename T, typename Policy>
+size_t listIndexOf(const List<T, Policy>* lst, size_t pos){
+    if (pos == 0 || pos > lst->size || !listHasMem(lst)){
+        return 0;
+    }
+    if (lst->sorted){
+        return pos;
+    }
+    if (lst->rank.nodes != nullptr){
+        return listRankKth(&(lst->rank), pos);
+    }
+    if (pos <= lst->size + 1 - pos){
+        return listWalk(lst, 0, 0, pos);
+    }
+    return listWalk(lst, 0, lst->size + 1, pos);
+}
+
+template<typename T, typename Policy>
+T listGetAt(const List<T, Policy>* lst, size_t pos, varError_t* err_ptr){
+    listCheckRetPtr(lst, err_ptr, ListElemInfo<T>::bad());
+
+    size_t ind = listIndexOf(lst, pos);
+    if (ind == 0){
+        if (err_ptr)
+            *err_ptr = VAR_BADOP;
+        return ListElemInfo<T>::bad();
+    }
+    return listData(lst, ind);
+}
+
+template<typename T, typename Policy>
+size_t listCursorSeek(const List<T, Policy>* lst, ListCursor* cur, size_t pos){
+    if (pos == 0 || pos > lst->size || !listHasMem(lst)){
+        return 0;
+    }
+
+    size_t ind = 0;
+    if (lst->sorted){
+        ind = pos;
+    }
+    else{
+        size_t from = 0;
+        size_t dist = pos;
+        if (lst->size + 1 - pos < dist){
+            from = lst->size + 1;
+            dist = lst->size + 1 - pos;
+        }
+
+        bool cur_ok = cur->pos != 0 && cur->pos <= lst->size &&
+                      cur->ind != 0 && cur->ind < lst->fmem_end && listPrev(lst, cur->ind) != cur->ind;
+        size_t cur_dist = cur_ok ? (cur->pos > pos ? cur->pos - pos : pos - cur->pos) : SIZE_MAX;
+
+        if (lst->rank.nodes != nullptr && cur_dist > LIST_RANK_WALK_MAX && dist > LIST_RANK_WALK_MAX){
+            ind = listRankKth(&(lst->rank), pos);
+        }
+        else if (cur_dist < dist){
+            ind = listWalk(lst, cur->ind, cur->pos, pos);
+        }
+        else{
+            ind = listWalk(lst, 0, from, pos);
+        }
+    }
+
+    cur->pos = pos;
+    cur->ind = ind;
+    return ind;
+}
+
+template<typename T, typename Policy>
+size_t listRankOf(const List<T, Policy>* lst, size_t ind){
+    if (ind == 0 || ind >= lst->fmem_end || !listHasMem(lst) || listPrev(lst, ind) == ind){
+        return 0;
+    }
+    if (lst->sorted){
+        return ind;
+    }
+    if (lst->rank.nodes != nullptr){
+        return listRankPos(&(lst->rank), ind);
+    }
+
+    size_t pos = 0;
+    for (size_t i = ind; i != 0; i = listPrev(lst, i)){
+        pos++;
+    }
+    return pos;
+}
+
+template<typename T, typename Policy>
+varError_t listRankIndexEnable(List<T, Policy>* lst){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (lst->rank.nodes == nullptr && !listRankMemResize(lst, lst->capacity, lst->capacity)){
+        return VAR_INTERR;
+    }
+    listRankBuild(lst);
+    return VAR_NOERROR;
+}
+
+template<typename T, typename Policy>
+void listRankIndexDisable(List<T, Policy>* lst){
+    free(lst->rank.nodes);
+    lst->rank.nodes = nullptr;
+    lst->rank.root  = 0;
+}
+
+template<typename T, typename Policy>
+varError_t listHashIndexEnable(List<T, Policy>* lst){
+    listCheckRet(lst, listError_dbg(lst));
+
+    if (!listHashBuild(lst)){
+        listHashIndexDisable(lst);
+        return VAR_INTERR;
+    }
+    return VAR_NOERROR;
+}
+
+template<typename T, typename Policy>
+void listHashIndexDisable(List<T, Policy>* lst){
+    free(lst->hash.table);
+    free(lst->hash.chain);
+    lst->hash.table      = nullptr;
+    lst->hash.chain      = nullptr;
+    lst->hash.table_size = 0;
+}
+
+template<typename T, typename Policy>
+size_t listHashFind(const List<T, Policy>* lst, T elem){
+    if (lst->hash.table != nullptr){
+        return lst->hash.table[listHashCell(lst, elem)];
+    }
+    if (listHasMem(lst)){
+        for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i)){
+            if (listData(lst, i) == elem)
+                return i;
+        }
+    }
+    return 0;
+}
+
+#endif // LIST_IMPL_H_INCLUDED
@@ -0,0 +1,396 @@
+#include <stdint.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "List.h"
+
+//File-backed list storage. File is a header page followed by one region per storage array
+//(data, next, prev or nodes), each region holds the array with its canaries. Regions start span
+//bytes apart and the file is sparse: a region grows into the hole after it, so growth within span
+//only extends the file and remaps it, no data moves. Span is doubled (regions move, last one
+//first) only when a region outgrows it. The move is recorded in header step by step, so if the
+//process dies in between it is finished on next open.
+
+static const char     LIST_MAP_MAGIC[8]    = "LISTMAP";
+static const uint32_t LIST_MAP_VERSION     = 2;
+static const size_t   LIST_MAP_HEADER_SIZE = 4096;
+//! smallest distance between regions: lists up to it never move their data
+static const size_t   LIST_MAP_MIN_SPAN    = (size_t)64 << 20;
+
+struct ListMapHeader{
+    char     magic[8];
+    uint32_t version;
+    uint32_t layout;
+    uint32_t arrays;
+    uint32_t offset;
+    uint64_t elem_size[LIST_MAP_MAX_ARRAYS];
+    uint64_t span;        //!< distance between region starts
+    uint64_t resize_span; //!< span regions are being moved to, 0 if no move is going on
+    uint64_t resize_left; //!< regions 1..resize_left-1 are still at old span
+    ListMapState state;
+};
+
+struct ListMapping{
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    char*  base;
+    size_t size;
+};
+
+//platform layer: file size, view of whole file, flush
+
+#ifdef _WIN32
+
+static size_t listMapPageSize(){
+    SYSTEM_INFO info = {};
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+}
+
+static bool listMapFileOpen(ListMapping* map, const char* path, size_t* file_size){
+    map->mapping = nullptr;
+    map->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (map->file == INVALID_HANDLE_VALUE){
+        return false;
+    }
+    //holes between regions take no disk space (fails harmlessly where sparse files are not supported)
+    DWORD returned = 0;
+    DeviceIoControl(map->file, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &returned, nullptr);
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(map->file, &size)){
+        CloseHandle(map->file);
+        return false;
+    }
+    *file_size = (size_t)size.QuadPart;
+    return true;
+}
+
+static void listMapUnview(ListMapping* map){
+    if (map->base != nullptr)
+        UnmapViewOfFile(map->base);
+    if (map->mapping != nullptr)
+        CloseHandle(map->mapping);
+    map->base    = nullptr;
+    map->mapping = nullptr;
+}
+
+//! maps size bytes of file, file is extended if it is shorter
+static bool listMapView(ListMapping* map, size_t size){
+    listMapUnview(map);
+    map->mapping = CreateFileMappingA(map->file, nullptr, PAGE_READWRITE,
+                                      (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+    if (map->mapping == nullptr){
+        return false;
+    }
+    map->base = (char*)MapViewOfFile(map->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (map->base == nullptr){
+        listMapUnview(map);
+        return false;
+    }
+    map->size = size;
+    return true;
+}
+
+static bool listMapTruncate(ListMapping* map, size_t size){
+    LARGE_INTEGER pos = {};
+    pos.QuadPart = (LONGLONG)size;
+    return SetFilePointerEx(map->file, pos, nullptr, FILE_BEGIN) && SetEndOfFile(map->file);
+}
+
+static bool listMapFlush(ListMapping* map){
+    return FlushViewOfFile(map->base, map->size) && FlushFileBuffers(map->file);
+}
+
+static void listMapFileClose(ListMapping* map){
+    listMapUnview(map);
+    CloseHandle(map->file);
+}
+
+#else // _WIN32
+
+static size_t listMapPageSize(){
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static bool listMapFileOpen(ListMapping* map, const char* path, size_t* file_size){
+    map->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (map->fd < 0){
+        return false;
+    }
+    struct stat st = {};
+    if (fstat(map->fd, &st) != 0){
+        close(map->fd);
+        return false;
+    }
+    *file_size = (size_t)st.st_size;
+    return true;
+}
+
+static void listMapUnview(ListMapping* map){
+    if (map->base != nullptr)
+        munmap(map->base, map->size);
+    map->base = nullptr;
+}
+
+//! maps size bytes of file, file is extended if it is shorter
+static bool listMapView(ListMapping* map, size_t size){
+    struct stat st = {};
+    if (fstat(map->fd, &st) != 0 || ((size_t)st.st_size < size && ftruncate(map->fd, (off_t)size) != 0)){
+        return false;
+    }
+    void* mem = MAP_FAILED;
+#if defined(__linux__)
+    if (map->base != nullptr){
+        mem = mremap(map->base, map->size, size, MREMAP_MAYMOVE);
+        if (mem == MAP_FAILED){
+            return false;
+        }
+        map->base = (char*)mem;
+        map->size = size;
+        return true;
+    }
+#endif
+    listMapUnview(map);
+    mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, map->fd, 0);
+    if (mem == MAP_FAILED){
+        return false;
+    }
+    map->base = (char*)mem;
+    map->size = size;
+    return true;
+}
+
+static bool listMapTruncate(ListMapping* map, size_t size){
+    return ftruncate(map->fd, (off_t)size) == 0;
+}
+
+static bool listMapFlush(ListMapping* map){
+    return msync(map->base, map->size, MS_SYNC) == 0;
+}
+
+static void listMapFileClose(ListMapping* map){
+    listMapUnview(map);
+    close(map->fd);
+}
+
+#endif // _WIN32
+
+static size_t listMapRegionSize(const ListMapLayout* layout, size_t k, size_t capacity){
+    size_t page = listMapPageSize();
+    size_t size = (capacity + 1) * layout->elem_size[k] + 2 * layout->offset;
+    return (size + page - 1) / page * page;
+}
+
+static size_t listMapRegionOffset(size_t span, size_t k){
+    return LIST_MAP_HEADER_SIZE + k * span;
+}
+
+//! file size: regions before last one take whole span, last one only what it needs
+static size_t listMapFileSize(const ListMapLayout* layout, size_t span, size_t capacity){
+    return listMapRegionOffset(span, layout->arrays - 1) + listMapRegionSize(layout, layout->arrays - 1, capacity);
+}
+
+//! smallest power of 2 span (at least LIST_MAP_MIN_SPAN) every region fits in
+static size_t listMapSpanFor(const ListMapLayout* layout, size_t capacity){
+    size_t need = 0;
+    for (size_t k = 0; k < layout->arrays; k++){
+        size_t size = listMapRegionSize(layout, k, capacity);
+        need = (size > need) ? size : need;
+    }
+    size_t span = LIST_MAP_MIN_SPAN;
+    while (span < need){
+        span *= 2;
+    }
+    return span;
+}
+
+static ListMapHeader* listMapHeader(const ListMapping* map){
+    return (ListMapHeader*)map->base;
+}
+
+static void listMapArrays(const ListMapping* map, const ListMapLayout* layout, void** arrays){
+    size_t span = listMapHeader(map)->span;
+    for (size_t k = 0; k < layout->arrays; k++){
+        arrays[k] = map->base + listMapRegionOffset(span, k) + layout->offset;
+    }
+}
+
+//! moves regions from span to resize_span as recorded in header, last one first.
+//! Region k goes from k*span to k*2^n*span, past old end of region k, so source of every region
+//! not moved yet is intact: after a crash the move is redone from resize_left on.
+//! File must already be long enough for new span
+static bool listMapMoveRegions(ListMapping* map, const ListMapLayout* layout){
+    ListMapHeader* header = listMapHeader(map);
+    size_t capacity = header->state.capacity;
+    for (size_t k = header->resize_left; k-- > 1; ){
+        memmove(map->base + listMapRegionOffset(header->resize_span, k),
+                map->base + listMapRegionOffset(header->span, k),
+                listMapRegionSize(layout, k, capacity));
+        if (!listMapFlush(map)){
+            return false;
+        }
+        header->resize_left = k;
+    }
+    header->span        = header->resize_span;
+    header->resize_span = 0;
+    header->resize_left = 0;
+    return listMapFlush(map);
+}
+
+//! doubles span until regions of new_capacity fit. O(capacity), but only when span is outgrown
+static bool listMapGrowSpan(ListMapping* map, const ListMapLayout* layout, size_t new_capacity){
+    ListMapHeader* header = listMapHeader(map);
+    size_t new_span = header->span;
+    while (new_span < listMapSpanFor(layout, new_capacity)){
+        new_span *= 2;
+    }
+    if (!listMapView(map, listMapFileSize(layout, new_span, header->state.capacity))){
+        return false;
+    }
+    header = listMapHeader(map);
+    header->resize_span = new_span;
+    header->resize_left = layout->arrays;
+    header->state.clean = 0;
+    return listMapFlush(map) && listMapMoveRegions(map, layout);
+}
+
+ListMapping* listMapOpen(const char* path, const ListMapLayout* layout, ListMapState* state,
+                         void** arrays, varError_t* err_ptr){
+    ListMapping* map = (ListMapping*)calloc(1, sizeof(ListMapping));
+    size_t file_size = 0;
+    if (map == nullptr || !listMapFileOpen(map, path, &file_size)){
+        perror_log("can not open list file");
+        free(map);
+        *err_ptr = VAR_INTERR;
+        return nullptr;
+    }
+
+    if (file_size == 0){
+        //new file: header, then zeroed regions (zero links are a valid empty list)
+        size_t span = listMapSpanFor(layout, state->capacity);
+        if (!listMapView(map, listMapFileSize(layout, span, state->capacity))){
+            perror_log("can not map list file");
+            listMapFileClose(map);
+            free(map);
+            *err_ptr = VAR_INTERR;
+            return nullptr;
+        }
+        ListMapHeader* header = listMapHeader(map);
+        memcpy(header->magic, LIST_MAP_MAGIC, sizeof(header->magic));
+        header->version = LIST_MAP_VERSION;
+        header->layout  = layout->layout;
+        header->arrays  = layout->arrays;
+        header->offset  = layout->offset;
+        for (size_t k = 0; k < LIST_MAP_MAX_ARRAYS; k++){
+            header->elem_size[k] = layout->elem_size[k];
+        }
+        header->span    = span;
+        state->clean    = 1;
+        header->state   = *state;
+    }
+    else{
+        ListMapHeader header = {};
+        if (file_size < LIST_MAP_HEADER_SIZE || !listMapView(map, file_size)){
+            Error_log("%s", "list file is too short or can not be mapped\n");
+            listMapFileClose(map);
+            free(map);
+            *err_ptr = VAR_BADOP;
+            return nullptr;
+        }
+        header = *listMapHeader(map);
+
+        bool match = memcmp(header.magic, LIST_MAP_MAGIC, sizeof(header.magic)) == 0 &&
+                     header.version == LIST_MAP_VERSION &&
+                     header.layout  == layout->layout   &&
+                     header.arrays  == layout->arrays   &&
+                     header.offset  == layout->offset   &&
+                     header.span    >= LIST_MAP_MIN_SPAN;
+        for (size_t k = 0; k < LIST_MAP_MAX_ARRAYS; k++){
+            match = match && header.elem_size[k] == layout->elem_size[k];
+        }
+        size_t span = (header.resize_span != 0) ? header.resize_span : header.span;
+        if (!match || header.resize_left > layout->arrays || file_size < listMapFileSize(layout, span, header.state.capacity)){
+            Error_log("%s", "list file has other format or element type\n");
+            listMapFileClose(map);
+            free(map);
+            *err_ptr = VAR_BADOP;
+            return nullptr;
+        }
+        if (header.resize_span != 0){
+            Error_log("%s", "list file was being resized, finishing it\n");
+            if (!listMapMoveRegions(map, layout)){
+                perror_log("can not resize list file");
+                listMapFileClose(map);
+                free(map);
+                *err_ptr = VAR_INTERR;
+                return nullptr;
+            }
+        }
+        *state = listMapHeader(map)->state;
+    }
+
+    listMapArrays(map, layout, arrays);
+    *err_ptr = VAR_NOERROR;
+    return map;
+}
+
+bool listMapResize(ListMapping* map, const ListMapLayout* layout, size_t old_capacity, size_t new_capacity, void** arrays){
+    (void)old_capacity;
+    if (listMapSpanFor(layout, new_capacity) > listMapHeader(map)->span && !listMapGrowSpan(map, layout, new_capacity)){
+        perror_log("can not move regions of list file");
+        return false;
+    }
+    size_t new_size = listMapFileSize(layout, listMapHeader(map)->span, new_capacity);
+
+    //header capacity never exceeds what file holds: it is raised after growth and lowered before shrinking
+    if (new_size > map->size){
+        if (!listMapView(map, new_size)){
+            perror_log("can not extend list file");
+            return false;
+        }
+        listMapHeader(map)->state.capacity = new_capacity;
+    }
+    else if (new_size < map->size){
+        listMapHeader(map)->state.capacity = new_capacity;
+        //longer file is still valid, so failed truncation is only reported
+        listMapUnview(map);
+        if (!listMapTruncate(map, new_size)){
+            perror_log("can not shrink list file");
+        }
+        if (!listMapView(map, new_size)){
+            perror_log("can not map list file");
+            return false;
+        }
+    }
+
+    //other state is written by listMapSync
+    listMapHeader(map)->state.capacity = new_capacity;
+    listMapHeader(map)->state.clean    = 0;
+    listMapArrays(map, layout, arrays);
+    return true;
+}
+
+bool listMapSync(ListMapping* map, const ListMapState* state){
+    listMapHeader(map)->state = *state;
+    if (!listMapFlush(map)){
+        perror_log("can not sync list file");
+        return false;
+    }
+    return true;
+}
+
+void listMapClose(ListMapping* map){
+    listMapFileClose(map);
+    free(map);
+}
@@ -0,0 +1,190 @@
+#include <string.h>
+
+#include "ListSimd.h"
+
+//Kernels are written once with GCC vector extensions and instantiated for
+//16-byte (SSE2) and 32-byte (AVX2) vectors. AVX2 versions are picked at runtime.
+//Other compilers and architectures get scalar loops.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define LIST_SIMD_X86 1
+#else
+    #define LIST_SIMD_X86 0
+#endif
+
+#if LIST_SIMD_X86
+
+#define LIST_SIMD_INLINE inline __attribute__((always_inline))
+
+//32-byte kernels are only inlined into target("avx2") functions, their ABI never matters
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+//integer type of the same size as T, for comparison masks
+template<size_t Size> struct ListSimdMask;
+template<> struct ListSimdMask<4>{ typedef int32_t type; };
+template<> struct ListSimdMask<8>{ typedef int64_t type; };
+
+template<typename T, int W>
+struct ListSimdKernel{
+    typedef T V __attribute__((vector_size(W)));
+    typedef typename ListSimdMask<sizeof(T)>::type M;
+    typedef M MV __attribute__((vector_size(W)));
+    static const size_t L = W / sizeof(T);
+
+    static LIST_SIMD_INLINE V load(const T* p){
+        V v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static LIST_SIMD_INLINE V splat(T x){
+        V v;
+        for (size_t k = 0; k < L; k++)
+            v[k] = x;
+        return v;
+    }
+
+    static LIST_SIMD_INLINE T sum(const T* a, size_t n){
+        V acc = splat(0);
+        size_t i = 0;
+        for (; i + L <= n; i += L){
+            acc += load(a + i);
+        }
+        T s = 0;
+        for (size_t k = 0; k < L; k++)
+            s += acc[k];
+        for (; i < n; i++)
+            s += a[i];
+        return s;
+    }
+
+    static LIST_SIMD_INLINE T min(const T* a, size_t n){
+        T m = a[0];
+        size_t i = 0;
+        if (n >= L){
+            V acc = load(a);
+            for (i = L; i + L <= n; i += L){
+                V v = load(a + i);
+                acc = (v < acc) ? v : acc;
+            }
+            for (size_t k = 0; k < L; k++)
+                m = (acc[k] < m) ? acc[k] : m;
+        }
+        for (; i < n; i++)
+            m = (a[i] < m) ? a[i] : m;
+        return m;
+    }
+
+    static LIST_SIMD_INLINE T max(const T* a, size_t n){
+        T m = a[0];
+        size_t i = 0;
+        if (n >= L){
+            V acc = load(a);
+            for (i = L; i + L <= n; i += L){
+                V v = load(a + i);
+                acc = (v > acc) ? v : acc;
+            }
+            for (size_t k = 0; k < L; k++)
+                m = (acc[k] > m) ? acc[k] : m;
+        }
+        for (; i < n; i++)
+            m = (a[i] > m) ? a[i] : m;
+        return m;
+    }
+
+    static LIST_SIMD_INLINE size_t find(const T* a, size_t n, T x){
+        V key = splat(x);
+        size_t i = 0;
+        for (; i + L <= n; i += L){
+            MV eq = (load(a + i) == key);
+            M any = 0;
+            for (size_t k = 0; k < L; k++)
+                any |= eq[k];
+            if (any){
+                break;
+            }
+        }
+        for (; i < n; i++){
+            if (a[i] == x)
+                return i;
+        }
+        return n;
+    }
+
+    static LIST_SIMD_INLINE size_t count(const T* a, size_t n, T x){
+        V key = splat(x);
+        MV acc = {};
+        size_t i = 0;
+        for (; i + L <= n; i += L){
+            acc -= (load(a + i) == key); //true lanes are -1
+        }
+        size_t c = 0;
+        for (size_t k = 0; k < L; k++)
+            c += acc[k];
+        for (; i < n; i++)
+            c += (a[i] == x);
+        return c;
+    }
+
+    static LIST_SIMD_INLINE void fill(T* a, size_t n, T x){
+        V v = splat(x);
+        size_t i = 0;
+        for (; i + L <= n; i += L){
+            memcpy(a + i, &v, sizeof(v));
+        }
+        for (; i < n; i++)
+            a[i] = x;
+    }
+};
+
+static bool listSimdHasAvx2(){
+    static const bool has = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return has;
+}
+
+#define LIST_SIMD_DEF(_type)                                                                   \
+    __attribute__((target("avx2"))) static _type   listSimdSumAvx2  (const _type* a, size_t n)           { return ListSimdKernel<_type, 32>::sum  (a, n); }    \
+    __attribute__((target("avx2"))) static _type   listSimdMinAvx2  (const _type* a, size_t n)           { return ListSimdKernel<_type, 32>::min  (a, n); }    \
+    __attribute__((target("avx2"))) static _type   listSimdMaxAvx2  (const _type* a, size_t n)           { return ListSimdKernel<_type, 32>::max  (a, n); }    \
+    __attribute__((target("avx2"))) static size_t  listSimdFindAvx2 (const _type* a, size_t n, _type x)  { return ListSimdKernel<_type, 32>::find (a, n, x); } \
+    __attribute__((target("avx2"))) static size_t  listSimdCountAvx2(const _type* a, size_t n, _type x)  { return ListSimdKernel<_type, 32>::count(a, n, x); } \
+    __attribute__((target("avx2"))) static void    listSimdFillAvx2 (_type* a, size_t n, _type x)        {        ListSimdKernel<_type, 32>::fill (a, n, x); } \
+                                                                                                \
+    _type listSimdSum(const _type* a, size_t n){                                               \
+        return listSimdHasAvx2() ? listSimdSumAvx2(a, n) : ListSimdKernel<_type, 16>::sum(a, n); \
+    }                                                                                          \
+    _type listSimdMin(const _type* a, size_t n){                                               \
+        return listSimdHasAvx2() ? listSimdMinAvx2(a, n) : ListSimdKernel<_type, 16>::min(a, n); \
+    }                                                                                          \
+    _type listSimdMax(const _type* a, size_t n){                                               \
+        return listSimdHasAvx2() ? listSimdMaxAvx2(a, n) : ListSimdKernel<_type, 16>::max(a, n); \
+    }                                                                                          \
+    size_t listSimdFind(const _type* a, size_t n, _type x){                                    \
+        return listSimdHasAvx2() ? listSimdFindAvx2(a, n, x) : ListSimdKernel<_type, 16>::find(a, n, x); \
+    }                                                                                          \
+    size_t listSimdCount(const _type* a, size_t n, _type x){                                   \
+        return listSimdHasAvx2() ? listSimdCountAvx2(a, n, x) : ListSimdKernel<_type, 16>::count(a, n, x); \
+    }                                                                                          \
+    void listSimdFill(_type* a, size_t n, _type x){                                            \
+        if (listSimdHasAvx2())                                                                 \
+            listSimdFillAvx2(a, n, x);                                                         \
+        else                                                                                   \
+            ListSimdKernel<_type, 16>::fill(a, n, x);                                          \
+    }
+
+#else // LIST_SIMD_X86
+
+#define LIST_SIMD_DEF(_type)                                                   \
+    _type  listSimdSum  (const _type* a, size_t n)          { return listScalarSum  (a, n); }    \
+    _type  listSimdMin  (const _type* a, size_t n)          { return listScalarMin  (a, n); }    \
+    _type  listSimdMax  (const _type* a, size_t n)          { return listScalarMax  (a, n); }    \
+    size_t listSimdFind (const _type* a, size_t n, _type x) { return listScalarFind (a, n, x); } \
+    size_t listSimdCount(const _type* a, size_t n, _type x) { return listScalarCount(a, n, x); } \
+    void   listSimdFill (_type* a, size_t n, _type x)       {        listScalarFill (a, n, x); }
+
+#endif // LIST_SIMD_X86
+
+LIST_SIMD_DEF(int   )
+LIST_SIMD_DEF(float )
+LIST_SIMD_DEF(double)
+
+#undef LIST_SIMD_DEF
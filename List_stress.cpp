@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <vector>
+
+#include "List.h"
+#include "ListParallel.h"
+#include "ListConcurrent.h"
+#include "lib/asserts.h"
+
+static const unsigned STRESS_THREADS = 8;
+static const size_t   STRESS_OPS     = 1 << 22;
+static const size_t   STRESS_HELD    = 48;  //!< slots held by every thread at most
+static const size_t   STRESS_CHAIN   = 8;   //!< slots given back by one listSlotReleaseChain
+
+typedef ListWithIndex<ListWithLayout<ListProtectPolicy, LIST_LAYOUT_NODES>, uint32_t> StressNodesPolicy;
+
+//! threads hammer listSlotAcquire / listSlotRelease / listSlotReleaseChain on a list that is too
+//! small for all of them, owner marks catch a slot handed out twice. After listSlotAllocEnd every
+//! slot must be free again: on free stack or in unused end, each once
+template<typename Policy>
+static void stressSlotAlloc(size_t used){
+    List<int, Policy> lst;
+    listCtor(&lst);
+
+    assert_e(listResize(&lst, used + STRESS_HELD * STRESS_THREADS / 2) == VAR_NOERROR);
+    size_t capacity = lst.capacity;
+
+    //some slots in use and some on free stack before allocator starts
+    size_t tail = 0;
+    for (size_t i = 0; i < used; i++){
+        tail = listPushAfter(&lst, tail, (int)i, nullptr);
+    }
+    for (size_t i = listNext(&lst, 0); i != 0; ){
+        size_t next = listNext(&lst, i);
+        if (i % 2)
+            listDeleteElem(&lst, i);
+        i = next;
+    }
+    size_t live = lst.size;
+    assert_e(lst.capacity == capacity);
+
+    std::vector<std::atomic<unsigned char> > owned(capacity + 1);
+    for (size_t i = listNext(&lst, 0); i != 0; i = listNext(&lst, i)){
+        owned[i].store(1);
+    }
+    std::atomic<size_t> double_taken(0);
+    std::atomic<size_t> acquired(0);
+
+    ListSlotAlloc alloc;
+    assert_e(listSlotAllocBegin(&lst, &alloc) == VAR_NOERROR);
+
+    listParallelRun(STRESS_THREADS, [&](unsigned t){
+        size_t held[STRESS_HELD] = {};
+        size_t held_count = 0;
+        unsigned rnd = 12345 + t;
+
+        for (size_t op = 0; op < STRESS_OPS / STRESS_THREADS; op++){
+            rnd = rnd * 1103515245 + 12345;
+            bool take = held_count == 0 || (held_count < STRESS_HELD && (rnd >> 16) % 2);
+            if (take){
+                size_t slot = listSlotAcquire(&lst, &alloc);
+                if (slot == 0)
+                    continue;
+                if (slot > capacity || owned[slot].exchange(1) != 0){
+                    double_taken++;
+                    continue;
+                }
+                held[held_count++] = slot;
+                acquired++;
+            }
+            else if ((rnd >> 20) % 4 == 0 && held_count >= STRESS_CHAIN){
+                //last STRESS_CHAIN held slots go back as one chain
+                size_t first = held[held_count - STRESS_CHAIN];
+                for (size_t k = held_count - STRESS_CHAIN; k < held_count; k++){
+                    owned[held[k]].store(0);
+                    if (k + 1 < held_count)
+                        listAtomicStore(&listNext(&lst, held[k]), held[k + 1]);
+                }
+                listSlotReleaseChain(&lst, &alloc, first, held[held_count - 1]);
+                held_count -= STRESS_CHAIN;
+            }
+            else{
+                size_t k = (rnd >> 8) % held_count;
+                size_t slot = held[k];
+                held[k] = held[--held_count];
+                owned[slot].store(0);
+                listSlotRelease(&lst, &alloc, slot);
+            }
+        }
+        for (size_t k = 0; k < held_count; k++){
+            owned[held[k]].store(0);
+            listSlotRelease(&lst, &alloc, held[k]);
+        }
+    });
+
+    assert_e(double_taken.load() == 0);
+    assert_e(acquired.load() > 0);
+    assert_e(listSlotAllocEnd(&lst, &alloc) == VAR_NOERROR);
+    assert_e(listError(&lst) == VAR_NOERROR);
+    assert_e(lst.size == live);
+
+    //every slot that is not in list is free exactly once
+    std::vector<bool> seen(capacity + 1, false);
+    for (size_t i = listNext(&lst, 0); i != 0; i = listNext(&lst, i)){
+        seen[i] = true;
+    }
+    size_t free_count = 0;
+    for (size_t i = lst.fmem_stack; i != 0; i = listNext(&lst, i)){
+        assert_e(i < lst.fmem_end && !seen[i] && listPrev(&lst, i) == i);
+        seen[i] = true;
+        free_count++;
+    }
+    free_count += capacity + 1 - lst.fmem_end;
+    assert_e(live + free_count == capacity);
+
+    //list is usable after allocator: all free slots can be taken
+    for (size_t i = 0; i < free_count; i++){
+        assert_e(listPushAfter(&lst, 0, (int)i, nullptr) != 0);
+    }
+    assert_e(lst.capacity == capacity && listError(&lst) == VAR_NOERROR);
+    listDtor(&lst);
+}
+
+static const size_t STRESS_CONC_OPS  = 1 << 18;
+static const size_t STRESS_CONC_SIZE = 512; //!< nodes in list when threads start
+
+//! threads push after, delete and read concurrent list at once: each deletes only nodes it
+//! pushed, so final size is known. Afterwards links must form one list of that size with
+//! every node pushed by a thread and not deleted, and stale indexes must be rejected
+template<typename Policy>
+static void stressConcList(){
+    List<int, Policy> lst;
+    listCtor(&lst);
+    assert_e(listResize(&lst, STRESS_CONC_SIZE) == VAR_NOERROR);
+    size_t tail = 0;
+    for (size_t i = 0; i < STRESS_CONC_SIZE; i++){
+        tail = listPushAfter(&lst, tail, -1, nullptr);
+    }
+
+    ListConcurrent<int, Policy> clst;
+    //preempted reader holds slot reuse for long: room for every push, so push never runs out
+    assert_e(listConcBegin(&clst, &lst, STRESS_CONC_SIZE + STRESS_CONC_OPS) == VAR_NOERROR);
+
+    std::vector<std::vector<size_t> > kept(STRESS_THREADS);
+    std::vector<std::vector<size_t> > gone(STRESS_THREADS);
+    std::atomic<size_t> bad_reads(0);
+    std::atomic<size_t> failed(0);
+
+    listParallelRun(STRESS_THREADS, [&](unsigned t){
+        std::vector<size_t>& mine = kept[t];
+        unsigned rnd = 777 + t;
+        for (size_t op = 0; op < STRESS_CONC_OPS / STRESS_THREADS; op++){
+            rnd = rnd * 1103515245 + 12345;
+            unsigned kind = (rnd >> 16) % 8;
+            if (kind < 3 && mine.size() < STRESS_HELD){
+                //after own node or sentinel: both stay live while this thread pushes
+                size_t after = mine.empty() ? 0 : mine[(rnd >> 8) % mine.size()];
+                varError_t err = VAR_NOERROR;
+                size_t x = listConcPushAfter(&clst, after, (int)t, &err);
+                if (x == 0){
+                    failed++;
+                    continue;
+                }
+                mine.push_back(x);
+            }
+            else if (kind < 5 && !mine.empty()){
+                size_t k = (rnd >> 8) % mine.size();
+                size_t x = mine[k];
+                mine[k] = mine.back();
+                mine.pop_back();
+                if (listConcDelete(&clst, x) != VAR_NOERROR)
+                    failed++;
+                gone[t].push_back(x);
+            }
+            else{
+                size_t reader = listConcReadBegin(&clst);
+                size_t steps = 0;
+                for (size_t i = listConcNext(&clst, 0); i != 0 && steps < 64; i = listConcNext(&clst, i), steps++){
+                    int elem = 0;
+                    if (listConcGet(&clst, i, &elem) && (elem < -1 || elem >= (int)STRESS_THREADS))
+                        bad_reads++;
+                }
+                listConcReadEnd(&clst, reader);
+            }
+        }
+    });
+
+    //deleted slots that were not reused, sentinel and slots past handed out ones are rejected
+    std::vector<bool> live_slot(lst.capacity + 1, false);
+    for (unsigned t = 0; t < STRESS_THREADS; t++){
+        for (size_t x : kept[t])
+            live_slot[x] = true;
+    }
+    size_t stale = 0;
+    for (unsigned t = 0; t < STRESS_THREADS; t++){
+        for (size_t x : gone[t]){
+            if (live_slot[x])
+                continue;
+            varError_t err = VAR_NOERROR;
+            assert_e(listConcDelete(&clst, x) == VAR_BADOP && listConcSet(&clst, x, 0) == VAR_BADOP);
+            assert_e(listConcPushAfter(&clst, x, 0, &err) == 0 && err == VAR_BADOP);
+            stale++;
+        }
+    }
+    assert_e(stale > 0);
+    assert_e(listConcDelete(&clst, 0) == VAR_BADOP);
+    assert_e(listConcSet(&clst, lst.capacity + 1, 0) == VAR_BADOP);
+    if (clst.alloc.end.load() <= lst.capacity){
+        assert_e(listConcDelete(&clst, lst.capacity) == VAR_BADOP);
+    }
+
+    assert_e(failed.load() == 0 && bad_reads.load() == 0);
+    size_t expect = STRESS_CONC_SIZE;
+    for (unsigned t = 0; t < STRESS_THREADS; t++){
+        expect += kept[t].size();
+    }
+    assert_e(clst.size.load() == expect);
+    assert_e(listConcEnd(&clst) == VAR_NOERROR);
+
+    assert_e(lst.size == expect && listError(&lst) == VAR_NOERROR);
+    std::vector<int> owner(lst.capacity + 1, -2);
+    size_t count = 0;
+    size_t prev = 0;
+    for (size_t i = listNext(&lst, 0); i != 0 && count <= lst.size; i = listNext(&lst, i)){
+        assert_e(listPrev(&lst, i) == prev && owner[i] == -2);
+        owner[i] = listData(&lst, i);
+        prev = i;
+        count++;
+    }
+    assert_e(count == expect && listPrev(&lst, 0) == prev);
+    for (unsigned t = 0; t < STRESS_THREADS; t++){
+        for (size_t x : kept[t]){
+            assert_e(owner[x] == (int)t);
+        }
+    }
+    listDtor(&lst);
+}
+
+int main(){
+    for (int round = 0; round < 4; round++){
+        stressSlotAlloc<ListProtectPolicy>(100);
+        stressSlotAlloc<ListProtectPolicy>(0);
+        stressSlotAlloc<StressNodesPolicy>(300);
+    }
+    for (int round = 0; round < 2; round++){
+        stressConcList<ListProtectPolicy>();
+        stressConcList<StressNodesPolicy>();
+    }
+    printf("%s", "slot allocator and concurrent list stress passed\n");
+    return 0;
+}
@@ -0,0 +1,857 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "List.h"
+#include "ListBatch.h"
+#include "ListParallel.h"
+#include "ListPool.h"
+#include "ListQueue.h"
+#include "ListSimd.h"
+#include "ListSnapshot.h"
+#include "SList.h"
+#include "lib/asserts.h"
+
+static const size_t TEST_RANGE_SIZE   = 1000;
+static const size_t TEST_RANGE_ROUNDS = 200;
+
+//! bulk insert must reuse slots freed by erase: capacity stays bounded by live size
+template<typename Policy>
+static void testInsertRangeReuse(bool indexed, bool compact){
+    List<int, Policy> lst;
+    listCtor(&lst);
+    if (indexed){
+        listRankIndexEnable(&lst);
+        listHashIndexEnable(&lst);
+    }
+    int src[TEST_RANGE_SIZE] = {};
+    for (size_t i = 0; i < TEST_RANGE_SIZE; i++){
+        src[i] = (int)i;
+    }
+
+    //a few nodes stay in list, so freed slots are scattered between them
+    size_t keep = listPushAfter(&lst, 0, -1, nullptr);
+    for (size_t round = 0; round < TEST_RANGE_ROUNDS; round++){
+        varError_t err = VAR_NOERROR;
+        size_t first = listInsertRangeAfter(&lst, (round % 2) ? keep : 0, src, TEST_RANGE_SIZE, &err);
+        assert_e(first != 0 && err == VAR_NOERROR);
+        assert_e(lst.size == TEST_RANGE_SIZE + 1);
+
+        size_t last = first;
+        for (size_t i = 0; i < TEST_RANGE_SIZE; i++){
+            assert_e(listData(&lst, last) == src[i]);
+            last = (i + 1 < TEST_RANGE_SIZE) ? listNext(&lst, last) : last;
+        }
+        if (indexed){
+            assert_e(listIndexOf(&lst, 1) == listNext(&lst, 0));
+            assert_e(listHashFind(&lst, src[TEST_RANGE_SIZE / 2]) != 0);
+        }
+        if (compact && round % 3 == 0){
+            listCompactBegin(&lst, 16);
+        }
+        assert_e(listEraseRange(&lst, first, last, TEST_RANGE_SIZE) == VAR_NOERROR);
+        assert_e(lst.size == 1 && listError(&lst) == VAR_NOERROR);
+        assert_e(lst.capacity <= 4 * (TEST_RANGE_SIZE + 1));
+    }
+    listDtor(&lst);
+}
+
+//! erased slots are marked free on every policy: stale indexes are rejected, scans skip them
+template<typename Policy>
+static void testEraseRangeMarks(){
+    List<int, Policy> lst;
+    listCtor(&lst);
+    size_t tail = 0;
+    for (int i = 0; i < 100; i++){
+        tail = listPushAfter(&lst, tail, i, nullptr);
+    }
+    size_t first = listNext(&lst, listNext(&lst, 0));
+    size_t last = first;
+    std::vector<size_t> erased(1, first);
+    for (int i = 0; i < 9; i++){
+        last = listNext(&lst, last);
+        erased.push_back(last);
+    }
+    assert_e(listEraseRange(&lst, first, last, 10) == VAR_NOERROR);
+    for (size_t ind : erased){
+        varError_t err = VAR_NOERROR;
+        assert_e(!listIsLive(&lst, ind));
+        assert_e(listPushAfter(&lst, ind, 0, &err) == 0 && err != VAR_NOERROR);
+    }
+    listSerialize(&lst, lst.size);
+    assert_e(lst.size == 90 && lst.sorted);
+    for (size_t i = 1; i <= lst.size; i++){
+        assert_e(listData(&lst, i) == (int)(i < 2 ? i - 1 : i + 9));
+    }
+    listDtor(&lst);
+}
+
+//! builds the same scattered list in both (deletes leave free slots all over storage)
+template<typename Policy>
+static void buildScattered(List<int, Policy>* a, List<int, Policy>* b, size_t n){
+    srand(7);
+    std::vector<size_t> inds;
+    for (size_t i = 0; i < n; i++){
+        size_t pos = inds.empty() ? 0 : inds[(size_t)rand() % inds.size()];
+        size_t ia = listPushAfter(a, pos, (int)i, nullptr);
+        size_t ib = listPushAfter(b, pos, (int)i, nullptr);
+        assert_e(ia != 0 && ia == ib);
+        inds.push_back(ia);
+    }
+    for (size_t i = 0; i < n / 4; i++){
+        size_t k = (size_t)rand() % inds.size();
+        assert_e(listDeleteElem(a, inds[k]) == VAR_NOERROR);
+        assert_e(listDeleteElem(b, inds[k]) == VAR_NOERROR);
+        inds[k] = inds.back();
+        inds.pop_back();
+    }
+}
+
+//! parallel rank, extraction and serialization match the sequential versions exactly
+template<typename Policy>
+static void testParallelMatch(){
+    const size_t n = LIST_PARALLEL_MIN_SIZE * 2;
+    const unsigned threads = 4;
+    List<int, Policy> seq;
+    List<int, Policy> par;
+    listCtor(&seq);
+    listCtor(&par);
+    buildScattered(&seq, &par, n);
+    assert_e(par.size > LIST_PARALLEL_MIN_SIZE);
+
+    std::vector<size_t> ranks(par.fmem_end, 1);
+    std::vector<size_t> ranks_seq(seq.fmem_end, 0);
+    std::vector<int> arr(par.size);
+    std::vector<int> arr_seq;
+    size_t pos = 0;
+    for (size_t i = listNext(&seq, 0); i != 0; i = listNext(&seq, i)){
+        ranks_seq[i] = ++pos;
+        arr_seq.push_back(listData(&seq, i));
+    }
+    assert_e(listRank(&par, ranks.data(), threads) == VAR_NOERROR);
+    assert_e(listToArray(&par, arr.data(), threads) == VAR_NOERROR);
+    assert_e(ranks == ranks_seq);
+    assert_e(arr == arr_seq);
+
+    size_t new_size = seq.capacity + 100;
+    assert_e(listSerialize(&seq, new_size) == VAR_NOERROR);
+    assert_e(listSerializeParallel(&par, new_size, threads) == VAR_NOERROR);
+    assert_e(listError(&par) == VAR_NOERROR);
+    assert_e(par.sorted && par.size == seq.size && par.capacity == seq.capacity && par.fmem_end == seq.fmem_end);
+    for (size_t i = 0; i < seq.fmem_end; i++){
+        assert_e(listNext(&par, i) == listNext(&seq, i));
+        assert_e(listPrev(&par, i) == listPrev(&seq, i));
+        assert_e(i == 0 || listData(&par, i) == listData(&seq, i));
+    }
+    listDtor(&par);
+    listDtor(&seq);
+}
+
+static const int TEST_KEY_MUL = 100000;
+
+//! compares keys only, rest of the value tells equal elements apart
+static bool testKeyLess(int a, int b){
+    return a / TEST_KEY_MUL < b / TEST_KEY_MUL;
+}
+
+//! value with key and tag (tag keeps order among equal keys)
+static int testKeyed(int key, int tag){
+    return key * TEST_KEY_MUL + tag;
+}
+
+template<typename L>
+static std::vector<int> listValues(const L* lst){
+    std::vector<int> vals;
+    for (size_t i = listNext(lst, 0); i != 0; i = listNext(lst, i)){
+        vals.push_back(listData(lst, i));
+    }
+    return vals;
+}
+
+//! sort keeps equal keys in list order, merge puts equal keys of dst before those of src
+template<typename Policy>
+static void testSortMerge(){
+    List<int, Policy> dst;
+    List<int, Policy> src;
+    listCtor(&dst);
+    listCtor(&src);
+    listResize(&dst, 16);
+    listResize(&src, 16);
+    srand(11);
+    for (int i = 0; i < 2000; i++){
+        //push at random ends so list order differs from storage order
+        size_t pos = (rand() % 2) ? 0 : listPrev(&dst, 0);
+        listPushAfter(&dst, pos, testKeyed(rand() % 20, 0), nullptr);
+        listPushAfter(&src, listPrev(&src, 0), testKeyed(rand() % 20, 0), nullptr);
+    }
+    //tags are list positions before sort
+    int tag = 0;
+    for (size_t i = listNext(&dst, 0); i != 0; i = listNext(&dst, i)){
+        listData(&dst, i) += tag++;
+    }
+    tag = TEST_KEY_MUL / 2;
+    for (size_t i = listNext(&src, 0); i != 0; i = listNext(&src, i)){
+        listData(&src, i) += tag++;
+    }
+
+    std::vector<int> expect = listValues(&dst);
+    std::stable_sort(expect.begin(), expect.end(), testKeyLess);
+    assert_e(listSort(&dst, testKeyLess) == VAR_NOERROR);
+    assert_e(listValues(&dst) == expect);
+    assert_e(listSort(&src, testKeyLess) == VAR_NOERROR);
+
+    std::vector<int> src_vals = listValues(&src);
+    size_t kept = listIndexOf(&dst, 7);
+    int kept_val = listData(&dst, kept);
+    expect.insert(expect.end(), src_vals.begin(), src_vals.end());
+    std::stable_sort(expect.begin(), expect.end(), testKeyLess);
+
+    assert_e(listMerge(&dst, &src, testKeyLess) == VAR_NOERROR);
+    assert_e(listValues(&dst) == expect);
+    assert_e(dst.size == 4000 && src.size == 0);
+    assert_e(listData(&dst, kept) == kept_val);
+    assert_e(listError(&dst) == VAR_NOERROR && listError(&src) == VAR_NOERROR);
+    listDtor(&src);
+    listDtor(&dst);
+}
+
+//! random push/delete/erase interleaved with compaction steps match a vector. After every step
+//! the compacted prefix holds logical positions in their slots, and its nodes keep their indexes
+//! while no mutation reaches it; when compaction is done list is sorted in storage
+template<typename Policy>
+static void testCompactInterleaved(){
+    List<int, Policy> lst;
+    listCtor(&lst);
+    std::vector<int> ref;
+    srand(5);
+    for (int i = 0; i < 3000; i++){
+        size_t pos = (size_t)rand() % (ref.size() + 1);
+        listPushAfter(&lst, listIndexOf(&lst, pos), i, nullptr);
+        ref.insert(ref.begin() + pos, i);
+    }
+
+    int next_val = 3000;
+    bool done = false;
+    for (int round = 0; !done; round++){
+        if (round < 400){
+            unsigned op = (unsigned)rand() % 4;
+            if (op == 0 || ref.size() < 10){
+                //push beyond compacted prefix keeps it valid
+                size_t pos = lst.compact_pos + (size_t)rand() % (ref.size() + 2 - lst.compact_pos);
+                pos = (pos > ref.size()) ? ref.size() : pos;
+                assert_e(listPushAfter(&lst, listIndexOf(&lst, pos), next_val, nullptr) != 0);
+                ref.insert(ref.begin() + pos, next_val++);
+            }
+            else if (op == 1){
+                size_t pos = 1 + (size_t)rand() % ref.size();
+                assert_e(listDeleteElem(&lst, listIndexOf(&lst, pos)) == VAR_NOERROR);
+                ref.erase(ref.begin() + (pos - 1));
+            }
+            else if (op == 2){
+                size_t pos = 1 + (size_t)rand() % (ref.size() - 5);
+                size_t n = 1 + (size_t)rand() % 5;
+                assert_e(listEraseRange(&lst, listIndexOf(&lst, pos), listIndexOf(&lst, pos + n - 1), n) == VAR_NOERROR);
+                ref.erase(ref.begin() + (pos - 1), ref.begin() + (pos - 1 + n));
+            }
+        }
+
+        varError_t err = VAR_NOERROR;
+        size_t prefix = lst.compact_pos;
+        done = listCompactStep(&lst, 7, &err);
+        assert_e(err == VAR_NOERROR && listError(&lst) == VAR_NOERROR);
+        if (done)
+            break;
+        assert_e(lst.compact_pos > prefix);
+        for (size_t k = 1; k < lst.compact_pos; k++){
+            assert_e(listNext(&lst, k - 1) == k && listData(&lst, k) == ref[k - 1]);
+        }
+
+        //step alone does not move nodes of the prefix
+        size_t kept = lst.compact_pos - 1;
+        assert_e(listCompactStep(&lst, 3, &err) || lst.compact_pos > kept);
+        for (size_t k = 1; k <= kept; k++){
+            assert_e(listData(&lst, k) == ref[k - 1] && listRankOf(&lst, k) == k);
+        }
+        done = (lst.compact_pos == 0);
+    }
+
+    assert_e(lst.sorted && lst.compact_pos == 0 && lst.fmem_end == lst.size + 1);
+    assert_e(listValues(&lst) == ref);
+    for (size_t k = 1; k <= lst.size; k++){
+        assert_e(listIndexOf(&lst, k) == k);
+    }
+    listDtor(&lst);
+}
+
+//! in-place serialization keeps list order and indexes whatever storage size it ends with
+template<typename Policy>
+static void testSerializeInPlace(){
+    List<int, Policy> lst;
+    List<int, Policy> unused;
+    listCtor(&lst);
+    listCtor(&unused);
+    buildScattered(&lst, &unused, 3000);
+    listDtor(&unused);
+    listRankIndexEnable(&lst);
+    listHashIndexEnable(&lst);
+    std::vector<int> ref = listValues(&lst);
+    assert_e(!lst.sorted && lst.size == ref.size());
+
+    assert_e(listSerialize(&lst, lst.size - 1) == VAR_BADOP);
+    size_t sizes[] = {lst.capacity, lst.capacity * 2, ref.size()};
+    for (size_t new_size : sizes){
+        assert_e(listSerialize(&lst, new_size) == VAR_NOERROR);
+        assert_e(listError(&lst) == VAR_NOERROR);
+        assert_e(lst.sorted && lst.capacity == new_size && lst.fmem_end == lst.size + 1);
+        assert_e(listValues(&lst) == ref);
+        for (size_t k = 1; k <= lst.size; k++){
+            assert_e(listNext(&lst, k - 1) == k && listData(&lst, k) == ref[k - 1]);
+            assert_e(listRankOf(&lst, k) == k && listHashFind(&lst, ref[k - 1]) == k);
+        }
+        //list goes on after it: new node takes next slot
+        size_t pushed = listPushAfter(&lst, listPrev(&lst, 0), -1, nullptr);
+        assert_e(pushed == ref.size() + 1 && listError(&lst) == VAR_NOERROR);
+        assert_e(listDeleteElem(&lst, pushed) == VAR_NOERROR);
+        //shuffle order in storage again: move every third node to front
+        for (size_t k = 3; k <= ref.size(); k += 3){
+            listSplice(&lst, 0, k, k);
+        }
+        ref = listValues(&lst);
+    }
+    listDtor(&lst);
+}
+
+//! order-statistic index follows every kind of mutation: positions and ranks match a vector
+template<typename Policy>
+static void testRankIndex(){
+    List<int, Policy> lst;
+    listCtor(&lst);
+    assert_e(listRankIndexEnable(&lst) == VAR_NOERROR);
+    std::vector<int> ref;
+    srand(13);
+    int next_val = 0;
+    int src[8] = {};
+    for (int round = 0; round < 3000; round++){
+        unsigned op = (unsigned)rand() % 6;
+        size_t pos = (size_t)rand() % (ref.size() + 1);
+        if (op <= 1 || ref.size() < 20){
+            assert_e(listPushAfter(&lst, listIndexOf(&lst, pos), next_val, nullptr) != 0);
+            ref.insert(ref.begin() + pos, next_val++);
+        }
+        else if (op == 2){
+            for (int k = 0; k < 8; k++){
+                src[k] = next_val++;
+            }
+            assert_e(listInsertRangeAfter(&lst, listIndexOf(&lst, pos), src, 8, nullptr) != 0);
+            ref.insert(ref.begin() + pos, src, src + 8);
+        }
+        else if (op == 3){
+            pos = 1 + pos % ref.size();
+            assert_e(listDeleteElem(&lst, listIndexOf(&lst, pos)) == VAR_NOERROR);
+            ref.erase(ref.begin() + (pos - 1));
+        }
+        else if (op == 4){
+            pos = 1 + pos % (ref.size() - 4);
+            assert_e(listEraseRange(&lst, listIndexOf(&lst, pos), listIndexOf(&lst, pos + 3), 4) == VAR_NOERROR);
+            ref.erase(ref.begin() + (pos - 1), ref.begin() + (pos + 3));
+        }
+        else{
+            //moves 3 nodes at pos to front
+            pos = 2 + pos % (ref.size() - 3);
+            assert_e(listSplice(&lst, 0, listIndexOf(&lst, pos), listIndexOf(&lst, pos + 2)) == VAR_NOERROR);
+            std::rotate(ref.begin(), ref.begin() + (pos - 1), ref.begin() + (pos + 2));
+        }
+        if (round % 100 == 0){
+            listCompactStep(&lst, 50);
+        }
+
+        size_t probe = 1 + (size_t)rand() % ref.size();
+        size_t ind = listIndexOf(&lst, probe);
+        assert_e(listData(&lst, ind) == ref[probe - 1] && listRankOf(&lst, ind) == probe);
+        assert_e(listGetAt(&lst, probe) == ref[probe - 1]);
+    }
+    assert_e(listIndexOf(&lst, 0) == 0 && listIndexOf(&lst, ref.size() + 1) == 0);
+    for (size_t k = 1; k <= ref.size(); k++){
+        size_t ind = listIndexOf(&lst, k);
+        assert_e(listData(&lst, ind) == ref[k - 1] && listRankOf(&lst, ind) == k);
+    }
+    assert_e(listError(&lst) == VAR_NOERROR);
+    listDtor(&lst);
+}
+
+//! every present value is found at its node and removed ones are not (values are unique)
+template<typename Policy>
+static void checkHash(const List<int, Policy>* lst, const std::vector<int>& present, const std::vector<int>& absent){
+    for (int v : present){
+        size_t ind = listHashFind(lst, v);
+        assert_e(ind != 0 && listData(lst, ind) == v);
+    }
+    for (int v : absent){
+        assert_e(listHashFind(lst, v) == 0);
+    }
+}
+
+//! value index follows mutations, slot moves of compaction and serialization,
+//! and is rebuilt by listFill and listTransform
+template<typename Policy>
+static void testHashIndex(){
+    List<int, Policy> lst;
+    listCtor(&lst);
+    assert_e(listHashIndexEnable(&lst) == VAR_NOERROR);
+    std::vector<int> gone;
+    srand(17);
+    int next_val = 0;
+    for (int round = 0; round < 3000; round++){
+        size_t size = lst.size;
+        unsigned op = (unsigned)rand() % 4;
+        size_t pos = (size == 0) ? 0 : 1 + (size_t)rand() % size;
+        if (op <= 1 || size < 10){
+            assert_e(listPushAfter(&lst, listIndexOf(&lst, pos), 2 * next_val++, nullptr) != 0);
+        }
+        else if (op == 2){
+            gone.push_back(listGetAt(&lst, pos));
+            assert_e(listDeleteElem(&lst, listIndexOf(&lst, pos)) == VAR_NOERROR);
+        }
+        else{
+            pos = (pos + 3 > size) ? size - 3 : pos;
+            for (size_t k = 0; k < 3; k++){
+                gone.push_back(listGetAt(&lst, pos + k));
+            }
+            assert_e(listEraseRange(&lst, listIndexOf(&lst, pos), listIndexOf(&lst, pos + 2), 3) == VAR_NOERROR);
+        }
+        if (round % 500 == 0){
+            listCompactStep(&lst, 100);
+        }
+    }
+    checkHash(&lst, listValues(&lst), gone);
+    assert_e(listSerialize(&lst, lst.capacity) == VAR_NOERROR);
+    checkHash(&lst, listValues(&lst), gone);
+
+    //values were even, odd ones after transform: none of old ones is left
+    std::vector<int> before = listValues(&lst);
+    assert_e(listTransform(&lst, [](int v){ return v + 1; }) == VAR_NOERROR);
+    checkHash(&lst, listValues(&lst), before);
+    //same on a list that is not dense
+    listSplice(&lst, 0, listPrev(&lst, 0), listPrev(&lst, 0));
+    assert_e(!lst.sorted);
+    before = listValues(&lst);
+    assert_e(listTransform(&lst, [](int v){ return v - 1; }) == VAR_NOERROR);
+    checkHash(&lst, listValues(&lst), before);
+
+    before = listValues(&lst);
+    assert_e(listFill(&lst, -7) == VAR_NOERROR);
+    assert_e(listData(&lst, listHashFind(&lst, -7)) == -7);
+    checkHash(&lst, std::vector<int>(), before);
+    assert_e(listError(&lst) == VAR_NOERROR);
+    listDtor(&lst);
+}
+
+static const char TEST_SNAPSHOT_PATH[] = "list_test_snapshot.bin";
+
+//! changes byte at offset of file (xor with mask) or cuts file to offset (mask == 0)
+static void damageFile(const char* path, long offset, int mask){
+    FILE* file = fopen(path, "rb");
+    assert_e(file != nullptr);
+    std::vector<char> bytes;
+    for (int c = fgetc(file); c != EOF; c = fgetc(file)){
+        bytes.push_back((char)c);
+    }
+    fclose(file);
+    if (mask == 0)
+        bytes.resize((size_t)offset);
+    else
+        bytes[(size_t)offset] ^= (char)mask;
+    file = fopen(path, "wb");
+    assert_e(file != nullptr);
+    fwrite(bytes.data(), 1, bytes.size(), file);
+    fclose(file);
+}
+
+//! saved list is loaded back in order into a list with content and indexes;
+//! damaged, cut and foreign files are rejected and leave a valid list
+template<typename Policy>
+static void testSnapshot(){
+    List<int, Policy> src;
+    List<int, Policy> dst;
+    listCtor(&src);
+    listCtor(&dst);
+    buildScattered(&src, &dst, 5000);
+    listClear(&dst);
+    listRankIndexEnable(&dst);
+    listHashIndexEnable(&dst);
+    listPushAfter(&dst, 0, -5, nullptr);
+    std::vector<int> ref = listValues(&src);
+
+    assert_e(listSaveSnapshot(&src, TEST_SNAPSHOT_PATH) == VAR_NOERROR);
+    assert_e(listLoadSnapshot(&dst, TEST_SNAPSHOT_PATH) == VAR_NOERROR);
+    assert_e(listError(&dst) == VAR_NOERROR && dst.sorted && dst.size == ref.size());
+    assert_e(listValues(&dst) == ref);
+    assert_e(listRankOf(&dst, listHashFind(&dst, ref[100])) == 101);
+    assert_e(listHashFind(&dst, -5) == 0);
+
+    List<long long, Policy> other;
+    listCtor(&other);
+    assert_e(listLoadSnapshot(&other, TEST_SNAPSHOT_PATH) == VAR_BADOP);
+    listDtor(&other);
+
+    long payload = (long)sizeof(ListSnapshotHeader);
+    damageFile(TEST_SNAPSHOT_PATH, payload + 4 * 1234 + 1, 0x10);
+    assert_e(listLoadSnapshot(&dst, TEST_SNAPSHOT_PATH) == VAR_CORRUPT);
+    assert_e(listError(&dst) == VAR_NOERROR && dst.size == 0);
+
+    assert_e(listSaveSnapshot(&src, TEST_SNAPSHOT_PATH) == VAR_NOERROR);
+    damageFile(TEST_SNAPSHOT_PATH, payload + 4 * 100, 0);
+    assert_e(listLoadSnapshot(&dst, TEST_SNAPSHOT_PATH) == VAR_BADOP);
+    assert_e(listSaveSnapshot(&src, TEST_SNAPSHOT_PATH) == VAR_NOERROR);
+    damageFile(TEST_SNAPSHOT_PATH, 0, 0x01);
+    assert_e(listLoadSnapshot(&dst, TEST_SNAPSHOT_PATH) == VAR_BADOP);
+    //count of header so big that count * sizeof(T) wraps around
+    assert_e(listSaveSnapshot(&src, TEST_SNAPSHOT_PATH) == VAR_NOERROR);
+    damageFile(TEST_SNAPSHOT_PATH, (long)offsetof(ListSnapshotHeader, count) + 7, 0x40);
+    assert_e(listLoadSnapshot(&dst, TEST_SNAPSHOT_PATH) == VAR_BADOP);
+    assert_e(listError(&dst) == VAR_NOERROR);
+
+    //empty list round trip
+    listClear(&src);
+    assert_e(listSaveSnapshot(&src, TEST_SNAPSHOT_PATH) == VAR_NOERROR);
+    listPushAfter(&dst, 0, 1, nullptr);
+    assert_e(listLoadSnapshot(&dst, TEST_SNAPSHOT_PATH) == VAR_NOERROR && dst.size == 0);
+    assert_e(listError(&dst) == VAR_NOERROR);
+
+    remove(TEST_SNAPSHOT_PATH);
+    listDtor(&dst);
+    listDtor(&src);
+}
+
+static const size_t TEST_QUEUE_CAPACITY = 64;
+static const int    TEST_QUEUE_ITEMS    = 200000;
+
+//! queue is FIFO with elements already in list first, push fails only when list is full,
+//! and listQueueEnd gives list of what is left in order. Then producers run concurrently
+//! with consumer: elements of every producer come out in order, none is lost
+template<typename Policy>
+static void testQueueOrder(ListQueueMode mode){
+    List<int, Policy> lst;
+    listCtor(&lst);
+    std::deque<int> ref;
+    for (int i = 0; i < 5; i++){
+        listPushAfter(&lst, 0, -i, nullptr);
+        ref.push_front(-i);
+    }
+
+    ListQueue<int, Policy> queue;
+    assert_e(listQueueBegin(&queue, &lst, mode, TEST_QUEUE_CAPACITY) == VAR_NOERROR);
+    size_t capacity = lst.capacity;
+    srand(19);
+    int next_val = 0;
+    int batch[7] = {};
+    for (int round = 0; round < 20000; round++){
+        unsigned op = (unsigned)rand() % 3;
+        if (op == 0 || (op == 1 && round % 1000 < 500)){
+            bool pushed = listQueuePush(&queue, next_val);
+            assert_e(pushed || ref.size() + 1 >= capacity);
+            if (pushed)
+                ref.push_back(next_val++);
+        }
+        else if (op == 1){
+            int elem = 0;
+            bool popped = listQueuePop(&queue, &elem);
+            assert_e(popped == !ref.empty());
+            if (popped){
+                assert_e(elem == ref.front());
+                ref.pop_front();
+            }
+        }
+        else{
+            size_t n = listQueuePopBatch(&queue, batch, 7);
+            assert_e(n == std::min<size_t>(7, ref.size()));
+            for (size_t k = 0; k < n; k++){
+                assert_e(batch[k] == ref.front());
+                ref.pop_front();
+            }
+        }
+    }
+    assert_e(listQueueEnd(&queue) == VAR_NOERROR);
+    assert_e(listError(&lst) == VAR_NOERROR && lst.capacity == capacity);
+    std::vector<int> left(ref.begin(), ref.end());
+    assert_e(listValues(&lst) == left);
+
+    //concurrent: SPSC has one producer, MPSC three
+    unsigned producers = (mode == LIST_QUEUE_SPSC) ? 1 : 3;
+    listClear(&lst);
+    assert_e(listQueueBegin(&queue, &lst, mode) == VAR_NOERROR);
+    std::vector<int> seen(producers, 0);
+    listParallelRun(producers + 1, [&](unsigned t){
+        if (t > 0){
+            for (int i = 0; i < TEST_QUEUE_ITEMS; i++){
+                while (!listQueuePush(&queue, (int)(t - 1) * TEST_QUEUE_ITEMS + i))
+                    std::this_thread::yield();
+            }
+            return;
+        }
+        size_t total = 0;
+        while (total < producers * (size_t)TEST_QUEUE_ITEMS){
+            size_t n = listQueuePopBatch(&queue, batch, 7);
+            if (n == 0)
+                std::this_thread::yield();
+            for (size_t k = 0; k < n; k++){
+                int p = batch[k] / TEST_QUEUE_ITEMS;
+                assert_e(p >= 0 && p < (int)producers && batch[k] % TEST_QUEUE_ITEMS == seen[p]);
+                seen[p]++;
+            }
+            total += n;
+        }
+    });
+    assert_e(listQueueEnd(&queue) == VAR_NOERROR);
+    assert_e(lst.size == 0 && listError(&lst) == VAR_NOERROR);
+    listDtor(&lst);
+}
+
+//! random batch operations: commit matches a model of the list, rollback (and commit after
+//! failed operation) gives back same order, same values at same indexes and same free memory
+template<typename Policy>
+static void testBatchRollback(){
+    List<int, Policy> lst;
+    List<int, Policy> unused;
+    listCtor(&lst);
+    listCtor(&unused);
+    buildScattered(&lst, &unused, 2000);
+    listDtor(&unused);
+
+    ListBatch<int, Policy> batch;
+    srand(23);
+    int next_val = 100000;
+    for (int round = 0; round < 30; round++){
+        std::vector<size_t> order;
+        for (size_t i = listNext(&lst, 0); i != 0; i = listNext(&lst, i))
+            order.push_back(i);
+        std::vector<int> values = listValues(&lst);
+        size_t fmem_stack = lst.fmem_stack;
+        size_t fmem_end   = lst.fmem_end;
+        bool sorted       = lst.sorted;
+
+        assert_e(listBatchBegin(&lst, &batch, 16) == VAR_NOERROR);
+        std::vector<size_t> model = order;
+        std::vector<size_t> deleted;
+        for (int op = 0; op < 200; op++){
+            unsigned kind = (unsigned)rand() % 3;
+            size_t k = (size_t)rand() % (model.size() + 1);
+            if (kind == 0 || model.size() < 2){
+                size_t ind = (k == 0) ? 0 : model[k - 1];
+                size_t x = listBatchPushAfter(&batch, ind, next_val++, nullptr);
+                assert_e(x != 0);
+                model.insert(model.begin() + (ptrdiff_t)k, x);
+            }
+            else if (kind == 1){
+                k %= model.size();
+                assert_e(listBatchDelete(&batch, model[k]) == VAR_NOERROR);
+                deleted.push_back(model[k]);
+                model.erase(model.begin() + (ptrdiff_t)k);
+            }
+            else{
+                k %= model.size();
+                size_t ind = model[k];
+                model.erase(model.begin() + (ptrdiff_t)k);
+                size_t d = (size_t)rand() % (model.size() + 1);
+                assert_e(listBatchMoveAfter(&batch, ind, (d == 0) ? 0 : model[d - 1]) == VAR_NOERROR);
+                model.insert(model.begin() + (ptrdiff_t)d, ind);
+            }
+        }
+
+        if (round % 3 == 0){
+            std::vector<int> expect;
+            for (size_t ind : model){
+                expect.push_back(listData(&lst, ind));
+            }
+            assert_e(listBatchCommit(&batch) == VAR_NOERROR);
+            assert_e(listError(&lst) == VAR_NOERROR && lst.size == model.size());
+            assert_e(listValues(&lst) == expect);
+            continue;
+        }
+        if (round % 3 == 1){
+            assert_e(listBatchRollback(&batch) == VAR_NOERROR);
+        }
+        else{
+            //stale index (slot may be taken again by later push): operation fails, commit rolls everything back
+            size_t stale = 0;
+            for (size_t ind : deleted){
+                if (std::find(model.begin(), model.end(), ind) == model.end())
+                    stale = ind;
+            }
+            assert_e(stale != 0);
+            assert_e(listBatchDelete(&batch, stale) == VAR_BADOP);
+            assert_e(listBatchPushAfter(&batch, 0, -1, nullptr) != 0);
+            assert_e(listBatchCommit(&batch) == VAR_BADOP);
+        }
+        assert_e(listError(&lst) == VAR_NOERROR && lst.size == order.size());
+        assert_e(listValues(&lst) == values);
+        for (size_t i = 0; i < order.size(); i++){
+            assert_e(listData(&lst, order[i]) == values[i]);
+        }
+        assert_e(lst.fmem_stack == fmem_stack && lst.fmem_end == fmem_end && lst.sorted == sorted);
+        //closed batch can not be committed or rolled back again
+        assert_e(listBatchCommit(&batch) == VAR_BADOP && listBatchRollback(&batch) == VAR_BADOP);
+    }
+    listDtor(&lst);
+}
+
+//! pool storage is many rings (empty list sentinel looks like a free slot), paranoid tier must accept it
+static void testPoolParanoid(){
+    ListPool<int> pool;
+    listPoolCtor(&pool);
+    assert_e(listSetCheckTier(&(pool.mem), LIST_CHECK_PARANOID) == VAR_NOERROR);
+
+    PoolList<int> a;
+    PoolList<int> b;
+    PoolList<int> empty;
+    assert_e(poolListCtor(&a, &pool) == VAR_NOERROR);
+    assert_e(poolListCtor(&b, &pool) == VAR_NOERROR);
+    assert_e(poolListCtor(&empty, &pool) == VAR_NOERROR);
+    for (int i = 0; i < 50; i++){
+        varError_t err = VAR_NOERROR;
+        poolListPushBack((i % 2) ? &a : &b, i, &err);
+        assert_e(err == VAR_NOERROR);
+    }
+    assert_e(poolListDeleteElem(&a, poolListFirst(&a)) == VAR_NOERROR);
+    assert_e(listPoolError(&pool) == VAR_NOERROR);
+    assert_e(listCheckStats(&(pool.mem)).deep_count > 0);
+    listPoolDump(&pool);
+
+    poolListDtor(&empty);
+    poolListDtor(&b);
+    poolListDtor(&a);
+    listPoolDtor(&pool);
+}
+
+//! protected pools reject nodes of another list of the same pool
+static void testPoolOwnership(){
+    ListPool<int, ListProtectPolicy> pool;
+    listPoolCtor(&pool);
+
+    PoolList<int, ListProtectPolicy> a;
+    PoolList<int, ListProtectPolicy> b;
+    assert_e(poolListCtor(&a, &pool) == VAR_NOERROR);
+    assert_e(poolListCtor(&b, &pool) == VAR_NOERROR);
+    for (int i = 0; i < 20; i++){
+        poolListPushBack((i % 2) ? &a : &b, i, nullptr);
+    }
+    size_t foreign = poolListFirst(&b);
+    varError_t err = VAR_NOERROR;
+    assert_e(poolListPushAfter(&a, foreign, 100, &err) == 0 && err == VAR_BADOP);
+    assert_e(poolListDeleteElem(&a, foreign) == VAR_BADOP);
+    assert_e(poolListDeleteElem(&a, b.head) == VAR_BADOP);
+    assert_e(poolListSplice(&a, 0, &a, foreign, foreign) == VAR_BADOP);
+    assert_e(poolListSplice(&a, foreign, &b, poolListLast(&b), poolListLast(&b)) == VAR_BADOP);
+    assert_e(a.size == 10 && b.size == 10);
+
+    //own nodes are still accepted
+    assert_e(poolListSplice(&a, poolListLast(&a), &b, foreign, foreign) == VAR_NOERROR);
+    assert_e(a.size == 11 && b.size == 9 && poolListLast(&a) == foreign);
+    assert_e(poolListDeleteElem(&a, foreign) == VAR_NOERROR);
+    assert_e(listPoolError(&pool) == VAR_NOERROR);
+
+    poolListDtor(&b);
+    poolListDtor(&a);
+    listPoolDtor(&pool);
+}
+
+template<typename L>
+static std::vector<int> slistValues(const L* lst){
+    std::vector<int> vals;
+    SListCursor cur = slistBegin(lst);
+    while (cur.ind != 0){
+        vals.push_back(lst->data[cur.ind]);
+        slistCursorNext(lst, &cur);
+    }
+    return vals;
+}
+
+//! random cursor inserts and erases match a vector; bad and stale cursors are rejected
+template<SListMode Mode>
+static void testSList(){
+    SList<int, Mode> lst;
+    slistCtor(&lst);
+    std::vector<int> ref;
+    srand(5);
+
+    for (int op = 0; op < 3000; op++){
+        size_t pos = ref.empty() ? 0 : (size_t)rand() % (ref.size() + 1);
+        SListCursor cur = slistBegin(&lst);
+        for (size_t k = 0; k < pos; k++){
+            slistCursorNext(&lst, &cur);
+        }
+        if (rand() % 3 != 0 || pos == ref.size()){
+            varError_t err = VAR_NOERROR;
+            assert_e(slistInsert(&lst, &cur, op, &err) != 0 && err == VAR_NOERROR);
+            ref.insert(ref.begin() + pos, op);
+        }
+        else{
+            assert_e(slistErase(&lst, &cur) == VAR_NOERROR);
+            ref.erase(ref.begin() + pos);
+        }
+    }
+    assert_e(slistValues(&lst) == ref && lst.size == ref.size());
+    assert_e(slistError(&lst) == VAR_NOERROR);
+
+    //paranoid tier walks to cursor, so every non-adjacent pair is caught
+    assert_e(slistSetCheckTier(&lst, LIST_CHECK_PARANOID) == VAR_NOERROR);
+    SListCursor a = slistBegin(&lst);
+    slistCursorNext(&lst, &a);
+    SListCursor b = a;
+    slistCursorNext(&lst, &b);
+    slistCursorNext(&lst, &b);
+    SListCursor skip = {a.prev, b.ind};
+    varError_t err = VAR_NOERROR;
+    assert_e(slistInsert(&lst, &skip, -1, &err) == 0 && err == VAR_BADOP);
+    assert_e(slistErase(&lst, &skip) == VAR_BADOP);
+
+    SListCursor stale = a;
+    assert_e(slistErase(&lst, &a) == VAR_NOERROR);
+    ref.erase(ref.begin() + 1);
+    assert_e(slistErase(&lst, &stale) == VAR_BADOP);
+    assert_e(slistValues(&lst) == ref);
+    assert_e(slistCheckStats(&lst).deep_count > 0);
+
+    //cheap tier counts O(1) checks
+    assert_e(slistSetCheckTier(&lst, LIST_CHECK_CHEAP) == VAR_NOERROR);
+    slistPushBack(&lst, 1, nullptr);
+    assert_e(slistCheckStats(&lst).cheap_count == 1);
+    slistDtor(&lst);
+}
+
+int main(){
+    testInsertRangeReuse<ListProtectPolicy>(false, false);
+    testInsertRangeReuse<ListProtectPolicy>(true , false);
+    testInsertRangeReuse<ListProtectPolicy>(false, true );
+    testInsertRangeReuse<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >(true, true);
+    testEraseRangeMarks<ListNoProtectPolicy>();
+    testEraseRangeMarks<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >();
+    testParallelMatch<ListProtectPolicy>();
+    testParallelMatch<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >();
+    testSortMerge<ListProtectPolicy>();
+    testSortMerge<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >();
+    testCompactInterleaved<ListProtectPolicy>();
+    testCompactInterleaved<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >();
+    testSerializeInPlace<ListProtectPolicy>();
+    testSerializeInPlace<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >();
+    testRankIndex<ListProtectPolicy>();
+    testRankIndex<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >();
+    testHashIndex<ListProtectPolicy>();
+    testHashIndex<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >();
+    testSnapshot<ListProtectPolicy>();
+    testSnapshot<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >();
+    testQueueOrder<ListProtectPolicy>(LIST_QUEUE_SPSC);
+    testQueueOrder<ListProtectPolicy>(LIST_QUEUE_MPSC);
+    testQueueOrder<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >(LIST_QUEUE_MPSC);
+    testBatchRollback<ListProtectPolicy>();
+    testBatchRollback<ListWithLayout<ListNoProtectPolicy, LIST_LAYOUT_NODES> >();
+    testPoolParanoid();
+    testPoolOwnership();
+    testSList<SLIST_FORWARD>();
+    testSList<SLIST_XOR>();
+    printf("%s", "all tests passed\n");
+    return 0;
+}
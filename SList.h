@@ -0,0 +1,623 @@
+#ifndef SLIST_H_INCLUDED
+#define SLIST_H_INCLUDED
+
+//! Lists with a single link array: forward-only (next) and XOR-linked (prev ^ next).
+//! Same index-linked design as List: slot 0 is sentinel, free slots are kept in
+//! fmem_stack (chained through link array) and fmem_end.
+//! Without prev array nodes are inserted and deleted through a cursor, which
+//! carries predecessor of the current node.
+
+#include "List.h"
+
+enum SListMode{
+    SLIST_FORWARD = 0, //!< link[i] = next(i)
+    SLIST_XOR     = 1, //!< link[i] = prev(i) ^ next(i), bidirectional
+};
+
+template<typename T, SListMode Mode, typename Policy = ListDefaultPolicy>
+struct SList{
+    typedef T      elem_t;
+    typedef Policy policy_t;
+    typedef typename Policy::index_t index_t;
+
+    canary_t leftcan;
+    VarInfo info;
+
+    size_t capacity;
+    size_t size;
+
+    T*       data;
+    index_t* link;
+
+    size_t head;
+    size_t tail;
+
+    size_t fmem_stack;
+    size_t fmem_end;
+
+    ListGrowth growth;
+    mutable ListCheckState check; //!< same check tiers as List (see listSetCheckTier)
+
+    canary_t rightcan;
+};
+
+template<typename T, typename Policy = ListDefaultPolicy>
+using FwdList = SList<T, SLIST_FORWARD, Policy>;
+
+template<typename T, typename Policy = ListDefaultPolicy>
+using XorList = SList<T, SLIST_XOR, Policy>;
+
+//! position in SList: current node ind and its logical predecessor prev.
+//! ind == 0 is the end position (past the tail), prev == 0 means ind is head
+struct SListCursor{
+    size_t prev;
+    size_t ind;
+};
+
+#ifdef slistCtor
+    #error redefinition of internal macro slistCtor
+#endif
+#define slistCtor(_lst)      \
+    if (slistCtor_(_lst)){  \
+        slistSetInfo(_lst, varInfoInit(_lst)); \
+    }                       \
+    else {                  \
+        Error_log("%s", "bad ptr passed to constructor\n");\
+    }
+
+#define slistCheckRet(__lst, ...)  \
+    if(slistCheck(__lst)){            \
+        Error_log("%s", "List error");\
+        slistDump(__lst);             \
+        return __VA_ARGS__;            \
+    }
+
+#define slistCheckRetPtr(__lst, __errptr, ...)  \
+    if(varError_t __check_err = slistCheck(__lst)){ \
+        Error_log("%s", "List error");   \
+        slistDump(__lst);                \
+        if(__errptr)                      \
+            *__errptr = __check_err;      \
+        return __VA_ARGS__;               \
+    }
+
+template<typename T, SListMode Mode, typename Policy>
+constexpr size_t slistDataBeginOffset(const SList<T, Mode, Policy>*){
+    return Policy::canary ?   sizeof(canary_t) : 0;
+}
+
+template<typename T, SListMode Mode, typename Policy>
+constexpr size_t slistDataSizeOffset(const SList<T, Mode, Policy>*){
+    return Policy::canary ? 2*sizeof(canary_t) : 0;
+}
+
+template<typename T, SListMode Mode, typename Policy>
+constexpr size_t slistMaxCapacity(const SList<T, Mode, Policy>*){
+    return (size_t)(typename Policy::index_t)(-1) - 1;
+}
+
+//! next node after ind, when prev is node before it
+template<typename T, SListMode Mode, typename Policy>
+inline size_t slistNextOf(const SList<T, Mode, Policy>* lst, size_t prev, size_t ind){
+    if (Mode == SLIST_XOR)
+        return lst->link[ind] ^ prev;
+    return lst->link[ind];
+}
+
+template<typename T, SListMode Mode, typename Policy>
+bool slistCtor_(SList<T, Mode, Policy>* lst){
+    if (Policy::check && !isPtrWritable(lst, sizeof(*lst))){
+        return false;
+    }
+
+    lst->data = nullptr;
+    lst->link = nullptr;
+
+    lst->head = 0;
+    lst->tail = 0;
+
+    lst->fmem_stack = 0;
+    lst->fmem_end   = 1;
+
+    lst->capacity = 0;
+    lst->size = 0;
+    lst->growth   = LIST_GROWTH_DEFAULT;
+    listCheckInit(&(lst->check), Policy::check);
+
+    if (Policy::canary){
+        lst->leftcan  = CANARY_L;
+        lst->rightcan = CANARY_R;
+    }
+    return true;
+}
+
+//! sets how capacity grows when list is full (see listSetGrowth)
+template<typename T, SListMode Mode, typename Policy>
+void slistSetGrowth(SList<T, Mode, Policy>* lst, ListGrowth growth){
+    lst->growth = growth;
+}
+
+template<typename T, SListMode Mode, typename Policy>
+static size_t slistGrowCapacity(const SList<T, Mode, Policy>* lst, size_t need_cap){
+    return listGrowthCapacity(&(lst->growth), lst->capacity, need_cap, slistMaxCapacity(lst));
+}
+
+template<typename T, SListMode Mode, typename Policy>
+void slistSetInfo(SList<T, Mode, Policy>* lst, VarInfo info){
+    if (Policy::varinfo){
+        lst->info = info;
+    }
+}
+
+template<typename T, SListMode Mode, typename Policy>
+static unsigned int slistArrError(const SList<T, Mode, Policy>* lst, bool probe, const void* arr, size_t elem_size){
+    unsigned int err = 0;
+    if (arr == nullptr)
+        return VAR_DATA_NULL;
+    if (probe && !isPtrWritable((uint8_t*)arr - slistDataBeginOffset(lst), (lst->capacity + 1) * elem_size + slistDataSizeOffset(lst)))
+        return VAR_DATA_BAD;
+
+    if (Policy::canary){
+        if (!checkLCanary(arr))
+            err |= VAR_DATA_CANARY_L_BAD;
+        if (!checkRCanary(arr, (lst->capacity + 1) * elem_size))
+            err |= VAR_DATA_CANARY_R_BAD;
+    }
+    return err;
+}
+
+//! slistError without pointer probes if probe is false (O(1), see LIST_CHECK_CHEAP)
+template<typename T, SListMode Mode, typename Policy>
+static varError_t slistError_(const SList<T, Mode, Policy>* lst, bool probe){
+    if (lst == nullptr)
+        return VAR_NULL;
+
+    if (probe && !isPtrReadable(lst, sizeof(*lst)))
+        return VAR_BAD;
+
+    if (lst->capacity == SIZE_MAX || lst->data == LIST_DESTRUCT_PTR)
+        return VAR_DEAD;
+
+    unsigned int err = 0;
+
+    if (lst->capacity != 0){
+        err |= slistArrError(lst, probe, lst->data, sizeof(T));
+        err |= slistArrError(lst, probe, lst->link, sizeof(typename Policy::index_t));
+    }
+
+    if (lst->fmem_stack >= lst->fmem_end ||
+        lst->size       >= lst->fmem_end ||
+        lst->head       >= lst->fmem_end ||
+        lst->tail       >= lst->fmem_end ||
+        lst->fmem_end   > lst->capacity + 1 ||
+        (lst->size == 0) != (lst->head == 0) ||
+        (lst->size == 0) != (lst->tail == 0))
+    {
+        err |= VAR_BADSTATE;
+    }
+
+    if (Policy::canary){
+        if (lst->leftcan != CANARY_L){
+            err |= VAR_CANARY_L_BAD;
+        }
+        if (lst->rightcan != CANARY_R){
+            err |= VAR_CANARY_R_BAD;
+        }
+    }
+
+    if (!(err & (VAR_DATA_BAD | VAR_DATA_NULL)) && lst->link != nullptr){
+        if (slistNextOf(lst, lst->tail, 0) != lst->head){
+            err |= VAR_BADSTATE;
+        }
+    }
+
+    if(err != 0){
+        err |= VAR_CORRUPT;
+    }
+
+    return (varError_t)err;
+}
+
+template<typename T, SListMode Mode, typename Policy>
+varError_t slistError(const SList<T, Mode, Policy>* lst){
+    return slistError_(lst, true);
+}
+
+//! walks list from head (LIST_CHECK_PARANOID): exactly size nodes, all in range, last one is tail
+template<typename T, SListMode Mode, typename Policy>
+static varError_t slistVerifyLinks(const SList<T, Mode, Policy>* lst){
+    if (lst->link == nullptr){
+        return VAR_NOERROR;
+    }
+    size_t prev  = 0;
+    size_t i     = lst->head;
+    size_t count = 0;
+    while (i != 0 && i < lst->fmem_end && count < lst->size){
+        size_t t = slistNextOf(lst, prev, i);
+        prev = i;
+        i = t;
+        count++;
+    }
+    if (i != 0 || count != lst->size || prev != lst->tail){
+        return (varError_t)(VAR_BADSTATE | VAR_CORRUPT);
+    }
+    return VAR_NOERROR;
+}
+
+//! check done by public operations, depth depends on check tier of list
+template<typename T, SListMode Mode, typename Policy>
+static varError_t slistCheck(const SList<T, Mode, Policy>* lst){
+    if (!Policy::check){
+        return VAR_NOERROR;
+    }
+    if (lst == nullptr){
+        return VAR_NULL;
+    }
+    ListCheckTier depth = listCheckDepth(&(lst->check));
+    if (depth == LIST_CHECK_OFF){
+        return VAR_NOERROR;
+    }
+    uint64_t start = lst->check.timing ? listClockNs() : 0;
+    varError_t err = slistError_(lst, depth != LIST_CHECK_CHEAP);
+    if (depth == LIST_CHECK_PARANOID && err == VAR_NOERROR){
+        err = slistVerifyLinks(lst);
+    }
+    listCheckCount(&(lst->check), depth, start);
+    return err;
+}
+
+//! sets check tier, see listSetCheckTier
+template<typename T, SListMode Mode, typename Policy>
+varError_t slistSetCheckTier(SList<T, Mode, Policy>* lst, ListCheckTier tier, size_t every = 1, size_t interval_ms = 0){
+    if (!Policy::check && tier != LIST_CHECK_OFF){
+        return VAR_BADOP;
+    }
+    return listCheckSetTier(&(lst->check), tier, every, interval_ms);
+}
+
+template<typename T, SListMode Mode, typename Policy>
+ListCheckStats slistCheckStats(const SList<T, Mode, Policy>* lst){
+    return lst->check.stats;
+}
+
+template<typename T, SListMode Mode, typename Policy>
+void slistDump(const SList<T, Mode, Policy>* lst){
+    hline_log();
+    varError_t err = slistError(lst);
+    printf_log("%s list dump\n", Mode == SLIST_XOR ? "XOR" : "Forward");
+    printf_log("    List at %p\n", lst);
+
+    if (err & (VAR_NULL | VAR_BAD)){
+        printBaseError_log((baseError_t) err);
+        hline_log();
+        return;
+    }
+
+    printf_log("    Data: %p\n", lst->data);
+    printf_log("    Link: %p\n", lst->link);
+    if (Policy::varinfo){
+        printVarInfo_log(&(lst->info));
+    }
+
+    if (err == VAR_NOERROR){
+       printf_log("    List ok\n");
+    }
+    else {
+       printf_log("    ERRORS:\n");
+       printBaseError_log((baseError_t) err);
+    }
+    if (err & VAR_BADSTATE){
+        printf_log("     (BAD) List in invalid state (indexes out of range)\n");
+    }
+    if (err & (VAR_DEAD | VAR_DATA_NULL | VAR_DATA_BAD) || lst->data == nullptr){
+        hline_log();
+        return;
+    }
+
+    printf_log("    Head: %lu Tail %lu Capacity %lu Size %lu\n", lst->head, lst->tail, lst->capacity, lst->size);
+    printf_log("    Free mem ptr: Stack: %lu Unused end: %lu\n", lst->fmem_stack, lst->fmem_end);
+
+    char elem_str[LIST_ELEM_STR_LEN] = "";
+    printf_log("I |");
+    for (size_t i = 1; i <= lst->capacity; i++){
+        printf_log("%5lu", i);
+    }
+    printf_log("\nD |");
+    for (size_t i = 1; i <= lst->capacity; i++){
+        ListElemInfo<T>::print(elem_str, LIST_ELEM_STR_LEN, lst->data[i]);
+        printf_log("%5s", elem_str);
+    }
+    printf_log("\nL |");
+    for (size_t i = 1; i <= lst->capacity; i++){
+        printf_log("%5lu", (size_t)lst->link[i]);
+    }
+    printf_log("\n");
+
+    printf_log("list elements in order:\n");
+    size_t prev = 0;
+    size_t i = lst->head;
+    size_t steps = 0;
+    while (i != 0 && i < lst->fmem_end && steps <= lst->size){
+        ListElemInfo<T>::print(elem_str, LIST_ELEM_STR_LEN, lst->data[i]);
+        printf_log("%s ", elem_str);
+        size_t t = slistNextOf(lst, prev, i);
+        prev = i;
+        i = t;
+        steps++;
+    }
+    if (i != 0){
+        printf_log("...Bad pointer");
+    }
+    printf_log("\n");
+    hline_log();
+}
+
+template<typename T, SListMode Mode, typename Policy>
+static void slistReplaceDataCanary(SList<T, Mode, Policy>* lst){
+    if (Policy::canary){
+        *((canary_t*)(lst->data + lst->capacity + 1)) = CANARY_R;
+        *((canary_t*)(lst->link + lst->capacity + 1)) = CANARY_R;
+
+        ((canary_t*)lst->data)[-1] = CANARY_L;
+        ((canary_t*)lst->link)[-1] = CANARY_L;
+    }
+}
+
+template<typename T, SListMode Mode, typename Policy>
+varError_t slistDtor(SList<T, Mode, Policy>* lst){
+    slistCheckRet(lst, slistError(lst));
+
+    if (lst->data != nullptr){
+        if (Policy::poison){
+            for (size_t i = 0; i <= lst->capacity; i++){
+                lst->data[i] = ListElemInfo<T>::bad();
+            }
+        }
+        free((uint8_t*)lst->data - slistDataBeginOffset(lst));
+        free((uint8_t*)lst->link - slistDataBeginOffset(lst));
+    }
+
+    lst->data = (T*)LIST_DESTRUCT_PTR;
+    lst->link = (typename Policy::index_t*)LIST_DESTRUCT_PTR;
+    lst->capacity = -1;
+    if (Policy::varinfo){
+        (lst->info).status = VARSTATUS_DEAD;
+    }
+    return VAR_NOERROR;
+}
+
+template<typename T, SListMode Mode, typename Policy>
+varError_t slistResize(SList<T, Mode, Policy>* lst, size_t new_capacity){
+    slistCheckRet(lst, slistError(lst));
+
+    if (new_capacity < lst->fmem_end - 1 || new_capacity > slistMaxCapacity(lst)){
+        return VAR_BADOP;
+    }
+
+    if (listAllocOrResize((void**)&(lst->data), (new_capacity + 1)*sizeof(T)                        + slistDataSizeOffset(lst), slistDataBeginOffset(lst)) &&
+        listAllocOrResize((void**)&(lst->link), (new_capacity + 1)*sizeof(typename Policy::index_t) + slistDataSizeOffset(lst), slistDataBeginOffset(lst))) {
+
+        size_t t = lst->capacity;
+        lst->capacity = new_capacity;
+
+        if (t == 0){
+            lst->link[0] = 0;
+        }
+
+        if (Policy::poison){
+            for(size_t i = t + 1; i <= new_capacity; i++){
+                lst->data[i] = ListElemInfo<T>::bad();
+                lst->link[i] = 0;
+            }
+        }
+
+        slistReplaceDataCanary(lst);
+        return VAR_NOERROR;
+    }
+    else {
+        Error_log("%s", "error while resizing list\n");
+        return VAR_INTERR;
+    }
+}
+
+template<typename T, SListMode Mode, typename Policy>
+static size_t slistGetFreeMem(SList<T, Mode, Policy>* lst){
+    if (lst->fmem_stack == 0){
+        if(lst->fmem_end <= lst->capacity)
+            return lst->fmem_end++;
+        else
+            return 0;
+    }
+    else {
+        size_t t = lst->fmem_stack;
+        lst->fmem_stack = lst->link[t];
+        return t;
+    }
+}
+
+template<typename T, SListMode Mode, typename Policy>
+static void slistAddFreeMem(SList<T, Mode, Policy>* lst, size_t ind){
+    if (Policy::poison){
+        lst->data[ind] = ListElemInfo<T>::bad();
+    }
+    lst->link[ind] = lst->fmem_stack;
+    lst->fmem_stack = ind;
+}
+
+//! cursor at the head of list
+template<typename T, SListMode Mode, typename Policy>
+SListCursor slistBegin(const SList<T, Mode, Policy>* lst){
+    SListCursor cur = {0, lst->head};
+    return cur;
+}
+
+//! cursor at the end position (after tail). Inserting there appends to the list
+template<typename T, SListMode Mode, typename Policy>
+SListCursor slistEnd(const SList<T, Mode, Policy>* lst){
+    SListCursor cur = {lst->tail, 0};
+    return cur;
+}
+
+//! moves cursor one node forward. Returns false if it was at the end
+template<typename T, SListMode Mode, typename Policy>
+bool slistCursorNext(const SList<T, Mode, Policy>* lst, SListCursor* cur){
+    if (cur->ind == 0)
+        return false;
+    size_t t = slistNextOf(lst, cur->prev, cur->ind);
+    cur->prev = cur->ind;
+    cur->ind  = t;
+    return true;
+}
+
+//! moves cursor one node back (XOR mode only). Returns false at the head or in forward mode
+template<typename T, SListMode Mode, typename Policy>
+bool slistCursorPrev(const SList<T, Mode, Policy>* lst, SListCursor* cur){
+    if (Mode != SLIST_XOR || cur->prev == 0)
+        return false;
+    size_t t = lst->link[cur->prev] ^ cur->ind;
+    cur->ind  = cur->prev;
+    cur->prev = t;
+    return true;
+}
+
+//! true unless p is node right before c (0 - sentinel). O(1) test: in forward mode link[p] is c,
+//! in XOR mode other neighbours of c and p (link[c] ^ p, link[p] ^ c) must link back to them.
+//! Paranoid tier also walks from head to the cursor (O(position))
+template<typename T, SListMode Mode, typename Policy>
+static bool slistCursorBad(const SList<T, Mode, Policy>* lst, size_t p, size_t c){
+    if (p >= lst->fmem_end || c >= lst->fmem_end){
+        return true;
+    }
+    if (lst->link == nullptr){
+        return p != 0 || c != 0;
+    }
+    if (p == c){
+        //only cursor of empty list is sentinel with itself
+        return p != 0 || lst->size != 0;
+    }
+    if (Mode == SLIST_FORWARD){
+        if (lst->link[p] != c)
+            return true;
+    }
+    else{
+        size_t n = lst->link[c] ^ p;
+        size_t q = lst->link[p] ^ c;
+        if (n >= lst->fmem_end || q >= lst->fmem_end ||
+            (lst->link[n] ^ c) >= lst->fmem_end || (lst->link[q] ^ p) >= lst->fmem_end)
+            return true;
+    }
+
+    if (Policy::check && lst->check.tier == LIST_CHECK_PARANOID){
+        size_t prev = 0;
+        size_t i = lst->head;
+        for (size_t steps = 0; steps <= lst->size; steps++){
+            if (prev == p && i == c)
+                return false;
+            size_t t = slistNextOf(lst, prev, i);
+            prev = i;
+            i = t;
+        }
+        return true;
+    }
+    return false;
+}
+
+//! inserts elem before cursor (between cur->prev and cur->ind).
+//! Cursor is moved to the new node, which index is returned (0 on error)
+template<typename T, SListMode Mode, typename Policy>
+size_t slistInsert(SList<T, Mode, Policy>* lst, SListCursor* cur, T elem, varError_t* err_ptr){
+    slistCheckRetPtr(lst, err_ptr, 0);
+
+    size_t p = cur->prev;
+    size_t c = cur->ind;
+    if (slistCursorBad(lst, p, c)){
+        if (err_ptr)
+            *err_ptr = VAR_BADOP;
+        return 0;
+    }
+
+    size_t ni = slistGetFreeMem(lst);
+    if (ni == 0){
+        if (lst->capacity >= slistMaxCapacity(lst)){
+            if (err_ptr)
+                *err_ptr = VAR_BADOP;
+            return 0;
+        }
+        varError_t err = slistResize(lst, slistGrowCapacity(lst, lst->capacity + 1));
+        if (err != VAR_NOERROR){
+            if (err_ptr)
+                *err_ptr = err;
+            return 0;
+        }
+        ni = slistGetFreeMem(lst);
+    }
+
+    lst->data[ni] = elem;
+    if (Mode == SLIST_XOR){
+        lst->link[ni] = p ^ c;
+        lst->link[p] ^= c ^ ni;
+        lst->link[c] ^= p ^ ni;
+    }
+    else{
+        lst->link[ni] = c;
+        lst->link[p]  = ni;
+    }
+
+    if (p == 0)
+        lst->head = ni;
+    if (c == 0)
+        lst->tail = ni;
+    lst->size++;
+
+    cur->ind = ni;
+    return ni;
+}
+
+//! deletes node at cursor. Cursor is moved to the following node
+template<typename T, SListMode Mode, typename Policy>
+varError_t slistErase(SList<T, Mode, Policy>* lst, SListCursor* cur){
+    slistCheckRet(lst, slistError(lst));
+
+    size_t p = cur->prev;
+    size_t x = cur->ind;
+    if (x == 0 || slistCursorBad(lst, p, x)){
+        return VAR_BADOP;
+    }
+    size_t b = slistNextOf(lst, p, x);
+    if (b >= lst->fmem_end){
+        return VAR_BADOP;
+    }
+
+    if (Mode == SLIST_XOR){
+        lst->link[p] ^= x ^ b;
+        lst->link[b] ^= x ^ p;
+    }
+    else{
+        lst->link[p] = b;
+    }
+
+    if (p == 0)
+        lst->head = b;
+    if (b == 0)
+        lst->tail = p;
+    lst->size--;
+
+    slistAddFreeMem(lst, x);
+
+    cur->ind = b;
+    return VAR_NOERROR;
+}
+
+template<typename T, SListMode Mode, typename Policy>
+size_t slistPushFront(SList<T, Mode, Policy>* lst, T elem, varError_t* err_ptr){
+    SListCursor cur = slistBegin(lst);
+    return slistInsert(lst, &cur, elem, err_ptr);
+}
+
+template<typename T, SListMode Mode, typename Policy>
+size_t slistPushBack(SList<T, Mode, Policy>* lst, T elem, varError_t* err_ptr){
+    SListCursor cur = slistEnd(lst);
+    return slistInsert(lst, &cur, elem, err_ptr);
+}
+
+#endif // SLIST_H_INCLUDED
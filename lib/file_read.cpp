@@ -17,7 +17,7 @@ size_t getFileSize( FILE* file){
     return file_size;
 }
 
-void* readBinFile(const char* filename, size_t* len){
+FILE* openBinFile(const char* filename, size_t* len){
     assert_retnull(filename != nullptr);
 
     FILE* file = fopen(filename, "rb");
@@ -26,7 +26,17 @@ void* readBinFile(const char* filename, size_t* len){
         return nullptr;
     }
 
-    size_t file_size = getFileSize(file)-1;
+    *len = getFileSize(file)-1;
+    return file;
+}
+
+void* readBinFile(const char* filename, size_t* len){
+    size_t file_size = 0;
+    FILE* file = openBinFile(filename, &file_size);
+    if (file == nullptr) {
+        return nullptr;
+    }
+
     char* file_content = (char*)calloc(file_size, sizeof(char));
     assert_retnull(file_content != nullptr);
 
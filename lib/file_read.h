@@ -29,6 +29,11 @@ String readFile( FILE* file);
 
 Text readFileLines(const char* filename);
 
+//! opens file for binary reading
+//! @param [out] len size of file in bytes
+//! @return file positioned at its start, nullptr in case of error
+FILE* openBinFile(const char* filename, size_t* len);
+
 void* readBinFile(const char* filename, size_t* len);
 
 #endif
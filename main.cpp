@@ -7,7 +7,7 @@ using namespace std;
 
 int main()
 {
-    List lst;
+    List<int> lst;
     listCtor(&lst);
     error_log("this program works\n");
     warn_log ("or it does not\n");
@@ -20,7 +20,7 @@ int main()
         listDeleteElem(&lst, i);
     }
 
-    lst.prev[5] = 7;
+    listPrev(&lst, 5) = 7;
     header_log("Before sort");
     listDump(&lst);
     listSerialize(&lst, lst.size);
@@ -30,5 +30,15 @@ int main()
 
     listDtor(&lst);
 
+    List<double, ListWithIndex<ListNoProtectPolicy, uint16_t> > fast_lst;
+    listCtor(&fast_lst);
+    size_t tail = 0;
+    for(int i = 0; i < 5; i++){
+        tail = listPushAfter(&fast_lst, tail, i * 0.5, nullptr);
+    }
+    header_log("Unprotected list");
+    listDump(&fast_lst, false);
+    listDtor(&fast_lst);
+
     return 0;
 }